@@ -5,7 +5,7 @@ import plotly.express as px
 import time
 import io
 import random
-from scheduler_wrapper import solve_scheduling, SchedulerLoadError
+from scheduler_wrapper import solve_scheduling, solve_scheduling_batch, GanttLod, SchedulerLoadError
 
 # --- PAGE CONFIG ---
 st.set_page_config(page_title="Hybrid OS Scheduler Pro", page_icon="🚀", layout="wide")
@@ -43,11 +43,22 @@ st.markdown("""
 if 'processes' not in st.session_state: st.session_state.processes = []
 if 'last_run_df' not in st.session_state: st.session_state.last_run_df = None
 if 'last_run_tl' not in st.session_state: st.session_state.last_run_tl = None
+if 'last_run_lod' not in st.session_state: st.session_state.last_run_lod = None
 if 'last_total_time' not in st.session_state: st.session_state.last_total_time = 0
 if 'step_mode_active' not in st.session_state: st.session_state.step_mode_active = False
 if 'current_step_time' not in st.session_state: st.session_state.current_step_time = 0
 
 # --- HELPER FUNCTIONS ---
+# Timelines longer than this are drawn from a GanttLod at about GANTT_PIXELS columns
+GANTT_LOD_THRESHOLD = 2000
+GANTT_PIXELS = 1000
+
+def build_lod(timeline):
+    return GanttLod(timeline) if len(timeline) > GANTT_LOD_THRESHOLD else None
+
+def chart_timeline(timeline, lod, t_end):
+    """The segments to draw for [0, t_end): all of them, or the LOD view of long timelines."""
+    return lod.query(0, t_end, GANTT_PIXELS) if lod is not None else timeline
 
 def generate_random_processes(count, max_at, min_bt, max_bt, max_prio):
     new_procs = []
@@ -75,7 +86,9 @@ def generate_random_processes(count, max_at, min_bt, max_bt, max_prio):
 def create_gantt_chart(gantt_data, total_duration, color_map, height=200):
     fig = go.Figure()
     ticks = set([0])
-    if gantt_data:
+    # A downsampled timeline has too many boundaries to label; Plotly picks the ticks
+    downsampled = bool(gantt_data) and 'Utilization' in gantt_data[0]
+    if gantt_data and not downsampled:
         ticks.update([s['Start'] for s in gantt_data])
         ticks.update([s['Finish'] for s in gantt_data])
     ticks = sorted(list(ticks))
@@ -84,16 +97,20 @@ def create_gantt_chart(gantt_data, total_duration, color_map, height=200):
 
     for segment in gantt_data:
         if segment['Task'] == "Idle": continue
+        hover = f"Task: {segment['Task']}<br>Time: {segment['Start']} - {segment['Finish']}"
+        if downsampled: hover += f"<br>CPU busy: {segment['Utilization']:.0%}"
         fig.add_trace(go.Bar(
             x=[segment['Finish'] - segment['Start']], y=["CPU"], base=[segment['Start']],
             orientation='h', marker=dict(color=color_map.get(segment['Task'], 'grey'), line=dict(color='black', width=1.5)),
             text=segment['Task'], textposition='inside', textfont=dict(color='white', size=14, family="Arial Black"),
-            hovertext=f"Task: {segment['Task']}<br>Time: {segment['Start']} - {segment['Finish']}", hoverinfo='text'
+            hovertext=hover, hoverinfo='text'
         ))
 
+    xaxis = dict(range=[0, max_x], showgrid=True, side='bottom')
+    if not downsampled: xaxis.update(tickmode='array', tickvals=ticks, ticktext=ticks)
     fig.update_layout(
         height=height, showlegend=False, margin=dict(l=10, r=10, t=10, b=30),
-        xaxis=dict(range=[0, max_x], tickmode='array', tickvals=ticks, ticktext=ticks, showgrid=True, side='bottom'),
+        xaxis=xaxis,
         yaxis=dict(showticklabels=False, showgrid=False), plot_bgcolor='white'
     )
     return fig
@@ -148,6 +165,7 @@ def run_scheduler_logic(algo, quant, mlq_assignments=None):
     
     st.session_state.last_run_df = final_df
     st.session_state.last_run_tl = timeline
+    st.session_state.last_run_lod = build_lod(timeline)
     st.session_state.last_total_time = total_time
     return True
 
@@ -351,7 +369,7 @@ with tab1:
 
             else:
                 # Standard Queue visualization
-                q_list = [p['pid'] for i,p in df.iterrows() if p['at']<=t and (pd.isnull(p['ct']) or p['ct']>t) and p['pid']!=curr_task]
+                q_list = df[(df['at'] <= t) & (df['ct'].isnull() | (df['ct'] > t)) & (df['pid'] != curr_task)]['pid'].tolist()
                 q_str = ' ➡️ '.join(q_list) if q_list else "Empty"
                 html = f"""
                 <div style="background-color: #f8f9fa; border: 1px solid #dee2e6; border-radius: 5px; padding: 10px; margin-bottom: 10px;">
@@ -365,6 +383,7 @@ with tab1:
         if st.session_state.last_run_df is not None:
             final_df = st.session_state.last_run_df
             timeline = st.session_state.last_run_tl
+            lod = st.session_state.last_run_lod
             total_time = st.session_state.last_total_time
             
             is_active = anim_clicked or (st.session_state.step_mode_active and st.session_state.current_step_time <= total_time)
@@ -379,20 +398,26 @@ with tab1:
                 for t in t_range:
                     # 1. Update Metrics
                     timer_placeholder.metric("⏱️ Current Time" if st.session_state.step_mode_active else "⏱️ Timer", f"{t}s")
-                    curr = "Idle"
-                    for s in timeline:
-                        if s['Start'] <= t < s['Finish']: curr = s['Task']
+                    if lod is not None:
+                        curr = lod.task_at(t)
+                    else:
+                        curr = "Idle"
+                        for s in timeline:
+                            if s['Start'] <= t < s['Finish']: curr = s['Task']
                     cpu_placeholder.metric("💻 CPU Process", curr)
                     
                     # 2. Queue
                     render_queue(t, final_df, curr)
 
                     # 3. Chart
-                    vis_data = []
-                    for s in timeline:
-                        if s['Finish'] <= t: vis_data.append(s)
-                        elif s['Start'] < t and s['Finish'] > t:
-                            temp = s.copy(); temp['Finish'] = t; vis_data.append(temp)
+                    if lod is not None:
+                        vis_data = lod.query(0, t, GANTT_PIXELS)
+                    else:
+                        vis_data = []
+                        for s in timeline:
+                            if s['Finish'] <= t: vis_data.append(s)
+                            elif s['Start'] < t and s['Finish'] > t:
+                                temp = s.copy(); temp['Finish'] = t; vis_data.append(temp)
                     
                     chart_placeholder.plotly_chart(create_gantt_chart(vis_data, total_time, color_map), use_container_width=True, key=f"anim_{t}")
                     
@@ -425,7 +450,7 @@ with tab1:
                 timer_placeholder.metric("⏱️ Total Time", f"{total_time}s")
                 cpu_placeholder.metric("💻 Status", "Completed")
                 render_queue(total_time, final_df, "Idle")
-                chart_placeholder.plotly_chart(create_gantt_chart(timeline, total_time, color_map), use_container_width=True)
+                chart_placeholder.plotly_chart(create_gantt_chart(chart_timeline(timeline, lod, total_time), total_time, color_map), use_container_width=True)
                 
                 with stats_placeholder.container():
                     st.markdown("### 📊 Final Statistics")
@@ -466,8 +491,10 @@ with tab2:
         if st.button("Compare Algorithms"):
             try:
                 # NOTE: We reuse mlq_assignments from Tab 1 for comparison runs
-                df1, tl1 = solve_scheduling(st.session_state.processes, algoA, qA, mlq_assigns_A)
-                df2, tl2 = solve_scheduling(st.session_state.processes, algoB, qB, mlq_assigns_B)
+                (df1, tl1, _), (df2, tl2, _) = solve_scheduling_batch(
+                    st.session_state.processes,
+                    [(algoA, qA, mlq_assigns_A), (algoB, qB, mlq_assigns_B)]
+                )
             except SchedulerLoadError as e:
                 st.error(str(e))
                 st.stop()
@@ -492,13 +519,13 @@ with tab2:
             g1, g2 = st.columns(2)
             with g1:
                 st.subheader(f"1. {algoA}")
-                st.plotly_chart(create_gantt_chart(tl1, max_t, color_map, 180), use_container_width=True, key="c1")
+                st.plotly_chart(create_gantt_chart(chart_timeline(tl1, build_lod(tl1), max_t), max_t, color_map, 180), use_container_width=True, key="c1")
                 st.write("#### Detailed Stats")
                 display_stats_table(df1)
 
             with g2:
                 st.subheader(f"2. {algoB}")
-                st.plotly_chart(create_gantt_chart(tl2, max_t, color_map, 180), use_container_width=True, key="c2")
+                st.plotly_chart(create_gantt_chart(chart_timeline(tl2, build_lod(tl2), max_t), max_t, color_map, 180), use_container_width=True, key="c2")
                 st.write("#### Detailed Stats")
                 display_stats_table(df2)
 
@@ -0,0 +1,284 @@
+// Benchmark suite for the scheduling engine. Sweeps every algorithm_code over workload
+// sizes, arrival densities, burst distributions, RR quanta and MLQ queue mixes, and
+// reports ns/event, segments/sec and peak memory as JSON (default) or CSV, so results
+// from two releases can be diffed. Linked against the shared library as built, with its
+// release flags. Not part of ctest; build with -DSCHEDULER_BUILD_BENCHMARKS=ON.
+//
+// usage: scheduler_bench [--max-n N] [--algo CODE] [--min-time SEC] [--seed S]
+//                        [--format json|csv] [--out FILE]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <fstream>
+#else
+#include <sys/resource.h>
+#endif
+
+// ABI of scheduler.cpp, as mirrored by scheduler_wrapper.py
+struct Process {
+    int pid, at, bt, priority, ct, tat, wt, rem_time, first_run, base_priority, current_priority;
+    int current_queue, last_q3_entry;
+};
+struct GanttLog {
+    int pid, start, finish;
+};
+struct SchedulerConfig;
+struct SchedulerContext;
+
+extern "C" {
+SchedulerContext* scheduler_context_create();
+void scheduler_context_destroy(SchedulerContext* ctx);
+int run_scheduler_context(SchedulerContext* ctx, Process* procs, int n, int algorithm_code, int quantum,
+                          const SchedulerConfig* config, GanttLog* logs, int max_logs, int flags);
+int scheduler_log_bound(const Process* procs, int n, int algorithm_code, int quantum);
+}
+
+static const char* kAlgoNames[] = {"FCFS", "SJF", "SRTF", "Prio-NP", "Prio-P", "RR", "MLFQ", "MLQ"};
+
+// --- Workloads ---
+// Arrivals are spread over n / density ticks; density 1 means about one arrival per tick.
+struct Density {
+    const char* name;
+    double per_tick;
+};
+static const Density kDensities[] = {{"sparse", 0.05}, {"moderate", 1.0}, {"burst", 50.0}};
+
+enum Burst { BURST_UNIFORM, BURST_EXPONENTIAL, BURST_BIMODAL };
+static const char* kBurstNames[] = {"uniform", "exponential", "bimodal"};
+
+// Share of processes in MLQ Q1/Q2 (the rest go to Q3)
+struct MlqMix {
+    const char* name;
+    double q1, q2;
+};
+static const MlqMix kMlqMixes[] = {{"q1-heavy", 0.6, 0.2}, {"balanced", 0.34, 0.33}, {"q3-heavy", 0.1, 0.2}};
+
+static const int kQuanta[] = {2, 8, 32};
+
+static std::vector<Process> make_workload(int n, const Density& density, Burst burst, const MlqMix* mix, unsigned seed) {
+    std::mt19937 rng(seed);
+    int span = std::max(1, (int)(n / density.per_tick));
+    std::uniform_int_distribution<int> arrival(0, span);
+    std::uniform_int_distribution<int> uniform(1, 20);
+    std::exponential_distribution<double> exponential(1.0 / 10.0);
+    std::uniform_int_distribution<int> short_job(1, 5), long_job(50, 200);
+    std::uniform_int_distribution<int> priority(1, 10);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    std::vector<Process> procs(n);
+    for (int i = 0; i < n; i++) {
+        Process& p = procs[i];
+        std::memset(&p, 0, sizeof(p));
+        p.pid = i + 1;
+        p.at = arrival(rng);
+        if (burst == BURST_UNIFORM) p.bt = uniform(rng);
+        else if (burst == BURST_EXPONENTIAL) p.bt = 1 + (int)std::min(1000.0, exponential(rng));
+        else p.bt = unit(rng) < 0.9 ? short_job(rng) : long_job(rng);
+        if (mix) {
+            // MLQ reads the queue id from priority
+            double u = unit(rng);
+            p.priority = u < mix->q1 ? 1 : (u < mix->q1 + mix->q2 ? 2 : 3);
+        } else {
+            p.priority = priority(rng);
+        }
+        p.rem_time = p.bt;
+        p.base_priority = p.current_priority = p.priority;
+        p.first_run = p.current_queue = p.last_q3_entry = -1;
+    }
+    return procs;
+}
+
+// --- Memory ---
+#if defined(__linux__)
+// Resets the peak RSS so each benchmark reports its own high-water mark.
+static void reset_peak_memory() {
+    std::ofstream clear("/proc/self/clear_refs");
+    if (clear) clear << "5";
+}
+
+static long long peak_memory_bytes() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) return std::atoll(line.c_str() + 6) * 1024;
+    }
+    return -1;
+}
+#else
+// Elsewhere the peak cannot be reset, so it is the process-wide peak so far.
+static void reset_peak_memory() {}
+
+static long long peak_memory_bytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return -1;
+    return (long long)counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return (long long)usage.ru_maxrss; // Bytes on macOS
+#else
+    return (long long)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+#endif
+
+// --- Runner ---
+struct Options {
+    int max_n = 1000000;
+    int algo = -1; // -1: all
+    double min_time = 0.2;
+    unsigned seed = 42;
+    bool csv = false;
+    const char* out = nullptr;
+};
+
+struct Result {
+    std::string name;
+    int algorithm_code, n, quantum;
+    const char* density;
+    const char* burst;
+    const char* mlq_mix;
+    long long iterations;
+    double ns_per_run, ns_per_event, segments_per_sec;
+    int segments;
+    long long peak_memory;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+// Repeats one configuration until min_time has elapsed (at least once, after a warm-up
+// run that also sizes the context). An event is one arrival or one Gantt segment.
+static Result run_case(SchedulerContext* ctx, const Options& opt, int code, int n, const Density& density,
+                       Burst burst, int quantum, const MlqMix* mix) {
+    std::vector<Process> input = make_workload(n, density, burst, mix, opt.seed);
+    std::vector<Process> procs = input;
+    int max_logs = std::max(1, scheduler_log_bound(input.data(), n, code, quantum));
+    std::vector<GanttLog> logs(max_logs);
+
+    reset_peak_memory();
+    int segments = run_scheduler_context(ctx, procs.data(), n, code, quantum, nullptr, logs.data(), max_logs, 0);
+
+    long long iterations = 0;
+    double elapsed = 0.0;
+    while (iterations == 0 || elapsed < opt.min_time) {
+        procs = input;
+        Clock::time_point start = Clock::now();
+        run_scheduler_context(ctx, procs.data(), n, code, quantum, nullptr, logs.data(), max_logs, 0);
+        elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+        iterations++;
+    }
+
+    Result r;
+    r.algorithm_code = code;
+    r.n = n;
+    r.quantum = quantum;
+    r.density = density.name;
+    r.burst = kBurstNames[burst];
+    r.mlq_mix = mix ? mix->name : "";
+    r.iterations = iterations;
+    r.segments = segments;
+    r.ns_per_run = elapsed * 1e9 / iterations;
+    r.ns_per_event = r.ns_per_run / ((double)n + segments);
+    r.segments_per_sec = segments / (elapsed / iterations);
+    r.peak_memory = peak_memory_bytes();
+    r.name = std::string(kAlgoNames[code]) + "/n=" + std::to_string(n) + "/" + r.density + "/" + r.burst;
+    if (code == 5) r.name += "/q=" + std::to_string(quantum);
+    if (mix) r.name += std::string("/") + mix->name;
+    std::fprintf(stderr, "%s\n", r.name.c_str()); // Progress
+    return r;
+}
+
+static void write_results(FILE* f, const Options& opt, const std::vector<Result>& results) {
+    if (opt.csv) {
+        std::fprintf(f, "name,algorithm_code,n,density,burst,quantum,mlq_mix,iterations,ns_per_run,ns_per_event,"
+                        "segments,segments_per_sec,peak_memory_bytes\n");
+        for (const Result& r : results) {
+            std::fprintf(f, "%s,%d,%d,%s,%s,%d,%s,%lld,%.1f,%.3f,%d,%.0f,%lld\n", r.name.c_str(), r.algorithm_code,
+                         r.n, r.density, r.burst, r.quantum, r.mlq_mix, r.iterations, r.ns_per_run, r.ns_per_event,
+                         r.segments, r.segments_per_sec, r.peak_memory);
+        }
+        return;
+    }
+    std::fprintf(f, "{\n  \"context\": {\"seed\": %u, \"min_time\": %.3f, \"max_n\": %d},\n  \"benchmarks\": [\n",
+                 opt.seed, opt.min_time, opt.max_n);
+    for (size_t k = 0; k < results.size(); k++) {
+        const Result& r = results[k];
+        std::fprintf(f,
+                     "    {\"name\": \"%s\", \"algorithm_code\": %d, \"n\": %d, \"density\": \"%s\", \"burst\": \"%s\", "
+                     "\"quantum\": %d, \"mlq_mix\": \"%s\", \"iterations\": %lld, \"ns_per_run\": %.1f, "
+                     "\"ns_per_event\": %.3f, \"segments\": %d, \"segments_per_sec\": %.0f, \"peak_memory_bytes\": %lld}%s\n",
+                     r.name.c_str(), r.algorithm_code, r.n, r.density, r.burst, r.quantum, r.mlq_mix, r.iterations,
+                     r.ns_per_run, r.ns_per_event, r.segments, r.segments_per_sec, r.peak_memory,
+                     k + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+}
+
+static bool parse_options(int argc, char** argv, Options& opt) {
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        const char* value = k + 1 < argc ? argv[k + 1] : nullptr;
+        if (arg == "--max-n" && value) opt.max_n = std::atoi(value);
+        else if (arg == "--algo" && value) opt.algo = std::atoi(value);
+        else if (arg == "--min-time" && value) opt.min_time = std::atof(value);
+        else if (arg == "--seed" && value) opt.seed = (unsigned)std::strtoul(value, nullptr, 10);
+        else if (arg == "--format" && value) opt.csv = std::strcmp(value, "csv") == 0;
+        else if (arg == "--out" && value) opt.out = value;
+        else return false;
+        k++;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_options(argc, argv, opt)) {
+        std::fprintf(stderr, "usage: %s [--max-n N] [--algo CODE] [--min-time SEC] [--seed S] "
+                             "[--format json|csv] [--out FILE]\n", argv[0]);
+        return 2;
+    }
+
+    SchedulerContext* ctx = scheduler_context_create();
+    if (!ctx) return 1;
+    std::vector<Result> results;
+    for (int code = 0; code < 8; code++) {
+        if (opt.algo != -1 && code != opt.algo) continue;
+        for (int n = 10; n <= opt.max_n; n *= 10) {
+            for (const Density& density : kDensities) {
+                for (int burst = BURST_UNIFORM; burst <= BURST_BIMODAL; burst++) {
+                    if (code == 5) {
+                        for (int q : kQuanta) results.push_back(run_case(ctx, opt, code, n, density, (Burst)burst, q, nullptr));
+                    } else if (code == 7) {
+                        for (const MlqMix& mix : kMlqMixes) results.push_back(run_case(ctx, opt, code, n, density, (Burst)burst, 2, &mix));
+                    } else {
+                        results.push_back(run_case(ctx, opt, code, n, density, (Burst)burst, 2, nullptr));
+                    }
+                }
+            }
+        }
+    }
+    scheduler_context_destroy(ctx);
+
+    FILE* f = opt.out ? std::fopen(opt.out, "w") : stdout;
+    if (!f) {
+        std::perror(opt.out);
+        return 1;
+    }
+    write_results(f, opt, results);
+    if (f != stdout) std::fclose(f);
+    return 0;
+}
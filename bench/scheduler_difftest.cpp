@@ -0,0 +1,898 @@
+// Differential tests of the scheduling engine. Each suite (see kSuites) runs seeded random
+// workloads (arrival ties, bursts of one tick, truncated Gantt buffers, presorted input,
+// MLQ queue mixes) through one entry point and checks it against an independent answer.
+// The reference suite compares the engine with the reference engine, the original
+// tick-by-tick run_scheduler kept in scheduler_reference.cpp: the return value,
+// ct/tat/wt/first_run/current_queue/current_priority of every process and the merged
+// Gantt logs must agree. It then times both engines on one larger workload per
+// algorithm_code and reports the speedup. Every case is derived from (seed, case number)
+// alone, so `--suite NAME --case K` replays a failure verbosely. Exits with 1 if any case
+// fails. Built as one translation unit with the engine and the reference engine, whatever
+// SCHEDULER_REFERENCE says, and registered with ctest one suite per test.
+//
+// usage: scheduler_difftest [--suite NAME] [--cases N] [--seed S] [--algo CODE] [--case K]
+//                           [--speed-n N] [--min-time SEC]
+
+#ifndef SCHEDULER_REFERENCE
+#define SCHEDULER_REFERENCE
+#endif
+#include "../scheduler.cpp" // Built as one translation unit with the engine
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+static const char* kAlgoNames[] = {"FCFS", "SJF", "SRTF", "Prio-NP", "Prio-P", "RR", "MLFQ", "MLQ"};
+
+// Compared outputs of each process
+struct Field {
+    const char* name;
+    int Process::*member;
+};
+static const Field kFields[] = {
+    {"ct", &Process::ct},
+    {"tat", &Process::tat},
+    {"wt", &Process::wt},
+    {"first_run", &Process::first_run},
+    {"current_queue", &Process::current_queue},
+    {"current_priority", &Process::current_priority},
+};
+
+struct Options {
+    std::string suite = "reference";
+    int cases = 20000;
+    unsigned seed = 1;
+    int algo = -1;     // -1: all
+    int replay = -1;   // --case
+    int speed_n = 2000;
+    double min_time = 0.2;
+};
+
+// --- Workloads ---
+struct Case {
+    int code, quantum, max_logs;
+    bool presorted;
+    std::vector<Process> procs;
+    int chunk_capacity; // run_scheduler_stream
+    unsigned check_seed; // Seeds the further draws of the other suites
+};
+
+static Process make_process(int pid, int at, int bt, int priority) {
+    Process p;
+    std::memset(&p, 0, sizeof(p));
+    p.pid = pid;
+    p.at = at;
+    p.bt = p.rem_time = bt;
+    p.priority = p.base_priority = p.current_priority = priority;
+    p.first_run = p.current_queue = p.last_q3_entry = -1;
+    return p;
+}
+
+static Case make_case(const Options& opt, int k) {
+    std::seed_seq seq{opt.seed, (unsigned)k};
+    std::mt19937 rng(seq);
+    Case c;
+    c.code = opt.algo >= 0 ? opt.algo : (int)(rng() % 8);
+    c.quantum = 1 + (int)(rng() % 8);
+    // Mostly tiny workloads, where ties and edge cases are dense, with some larger ones
+    int tier = (int)(rng() % 20);
+    int n = 1 + (int)(rng() % (tier == 0 ? 300 : tier < 5 ? 40 : 8));
+    // All at 0, crowded (many arrival ties) or spread out (idle gaps)
+    int spread = (int)(rng() % 3);
+    int max_at = spread == 0 ? 0 : spread == 1 ? n / 2 : n * 8;
+    int max_bt = (int)(rng() % 4) == 0 ? 120 : (rng() % 2 ? 30 : 3);
+    c.procs.resize(n);
+    for (int i = 0; i < n; i++) {
+        int priority = c.code == 7 ? 1 + (int)(rng() % 3) : 1 + (int)(rng() % 12);
+        c.procs[i] = make_process(i + 1, (int)(rng() % (max_at + 1)), 1 + (int)(rng() % max_bt), priority);
+    }
+    c.presorted = rng() % 3 == 0;
+    if (c.presorted) {
+        std::stable_sort(c.procs.begin(), c.procs.end(), [](const Process& a, const Process& b) { return a.at < b.at; });
+    }
+    c.max_logs = rng() % 10 == 0 ? 1 + (int)(rng() % 5) : std::max(1, scheduler_log_bound(c.procs.data(), n, c.code, c.quantum));
+    // Drawn last, so the reference workloads stay the same for a given seed
+    c.check_seed = (unsigned)rng();
+    c.chunk_capacity = 1 + (int)(rng() % 8);
+    return c;
+}
+
+// --- Comparison ---
+struct Outcome {
+    std::vector<Process> procs;
+    std::vector<GanttLog> logs;
+    int count;
+};
+
+static int flags_of(const Case& c) {
+    return c.presorted ? SCHED_FLAG_PRESORTED : 0;
+}
+
+static Outcome run_engine(const Case& c) {
+    Outcome out{c.procs, std::vector<GanttLog>(c.max_logs), 0};
+    int n = (int)out.procs.size();
+    out.count = run_scheduler_ex(out.procs.data(), n, c.code, c.quantum, out.logs.data(), c.max_logs, flags_of(c));
+    return out;
+}
+
+static Outcome run_config(const Case& c, const SchedulerConfig* config, int max_logs) {
+    Outcome out{c.procs, std::vector<GanttLog>(max_logs), 0};
+    int n = (int)out.procs.size();
+    out.count = run_scheduler_config(out.procs.data(), n, c.code, c.quantum, config, out.logs.data(), max_logs,
+                                     flags_of(c));
+    return out;
+}
+
+static Outcome run_reference(const Case& c) {
+    Outcome out{c.procs, std::vector<GanttLog>(c.max_logs), 0};
+    out.count = run_scheduler_reference(out.procs.data(), (int)out.procs.size(), c.code, c.quantum, out.logs.data(), c.max_logs);
+    return out;
+}
+
+// Describes the first difference between the two runs, or returns "" if they agree.
+static std::string first_difference(const Outcome& engine, const Outcome& ref, const char* other = "reference") {
+    char buf[160];
+    if (engine.count != ref.count) {
+        std::snprintf(buf, sizeof(buf), "returned %d segments, %s %d", engine.count, other, ref.count);
+        return buf;
+    }
+    for (size_t i = 0; i < ref.procs.size(); i++) {
+        for (const Field& f : kFields) {
+            int a = engine.procs[i].*f.member, b = ref.procs[i].*f.member;
+            if (a != b) {
+                std::snprintf(buf, sizeof(buf), "P%d %s = %d, %s %d", ref.procs[i].pid, f.name, a, other, b);
+                return buf;
+            }
+        }
+    }
+    for (int s = 0; s < ref.count; s++) {
+        const GanttLog& a = engine.logs[s];
+        const GanttLog& b = ref.logs[s];
+        if (a.pid != b.pid || a.start != b.start || a.finish != b.finish) {
+            std::snprintf(buf, sizeof(buf), "segment %d is %d:[%d, %d), %s %d:[%d, %d)", s, a.pid, a.start,
+                          a.finish, other, b.pid, b.start, b.finish);
+            return buf;
+        }
+    }
+    return "";
+}
+
+static void print_workload(const Case& c) {
+    std::printf("  algorithm_code %d (%s), quantum %d, max_logs %d%s\n  pid,at,bt,priority\n", c.code,
+                kAlgoNames[c.code], c.quantum, c.max_logs, c.presorted ? ", presorted" : "");
+    for (const Process& p : c.procs) std::printf("  %d,%d,%d,%d\n", p.pid, p.at, p.bt, p.priority);
+}
+
+static void print_case(const Case& c, const Outcome& engine, const Outcome& ref) {
+    print_workload(c);
+    std::printf("  engine segments | reference segments\n");
+    for (int s = 0; s < std::max(engine.count, ref.count); s++) {
+        if (s < engine.count) std::printf("  %d:[%d, %d)", engine.logs[s].pid, engine.logs[s].start, engine.logs[s].finish);
+        else std::printf("  -");
+        if (s < ref.count) std::printf(" | %d:[%d, %d)\n", ref.logs[s].pid, ref.logs[s].start, ref.logs[s].finish);
+        else std::printf(" | -\n");
+    }
+}
+
+// --- Suites ---
+// Each check runs one case and describes its first failure, or returns "" if it passes.
+typedef std::string (*CaseCheck)(const Case& c);
+
+static std::string failure(const char* format, ...) {
+    char buf[160];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return buf;
+}
+
+static std::string check_reference(const Case& c) {
+    return first_difference(run_engine(c), run_reference(c));
+}
+
+// No config, an all-zero config (every field keeps its default) and the defaults spelled
+// out must all run exactly like run_scheduler_ex.
+static std::string check_config(const Case& c) {
+    static const int kDefaultQuanta[] = {Q1_QUANTUM, Q2_QUANTUM};
+    const SchedulerConfig zero = {};
+    const SchedulerConfig defaults = {PRIORITY_AGING_RATE, 3, kDefaultQuanta, Q3_PROMOTION_THRESHOLD, MLQ_Q2_QUANTUM, 0, 0};
+    const SchedulerConfig* configs[] = {nullptr, &zero, &defaults};
+    const char* names[] = {"NULL config", "zero config", "default config"};
+    Outcome expected = run_engine(c);
+    for (int k = 0; k < 3; k++) {
+        std::string diff = first_difference(run_config(c, configs[k], c.max_logs), expected, "run_scheduler_ex");
+        if (!diff.empty()) return names[k] + (": " + diff);
+    }
+    return "";
+}
+
+// The total counted without a buffer fits scheduler_log_bound and is what a buffer of the
+// bound receives; a smaller buffer keeps the first max_logs segments of the same timeline.
+static std::string check_bound(const Case& c) {
+    int n = (int)c.procs.size();
+    int bound = scheduler_log_bound(c.procs.data(), n, c.code, c.quantum);
+    std::vector<Process> procs = c.procs;
+    int total = run_scheduler_config(procs.data(), n, c.code, c.quantum, nullptr, nullptr, 0, 0);
+    if (total > bound) return failure("%d segments, scheduler_log_bound %d", total, bound);
+    Outcome full = run_config(c, nullptr, std::max(1, bound));
+    if (full.count != total) return failure("stored %d of %d segments with a buffer of the bound", full.count, total);
+    Outcome truncated = run_engine(c);
+    if (truncated.count != std::min(total, c.max_logs)) {
+        return failure("stored %d segments in a buffer of %d, total %d", truncated.count, c.max_logs, total);
+    }
+    full.count = truncated.count;
+    return first_difference(truncated, full, "unbounded run");
+}
+
+// Checks one Gantt timeline of c: contiguous from 0, every process runs only after its
+// arrival and for cpu_time[i] ticks in total, and overhead segments appear only for a
+// non-zero cost, in whole switch_cost steps.
+static std::string timeline_failure(const Case& c, const Outcome& out, const std::vector<long long>& cpu_time,
+                                    int switch_cost = 0, int resume_penalty = 0) {
+    int n = (int)c.procs.size();
+    std::vector<int> index(n + 1); // pids are 1..n, possibly reordered by presorting
+    for (int i = 0; i < n; i++) index[c.procs[i].pid] = i;
+    std::vector<long long> ran(n, 0);
+    std::vector<int> last_finish(n, -1);
+    int time = 0;
+    for (int s = 0; s < out.count; s++) {
+        const GanttLog& seg = out.logs[s];
+        if (seg.start != time || seg.finish <= seg.start) return failure("gap or overlap at segment %d", s);
+        time = seg.finish;
+        if (seg.pid == GANTT_PID_SWITCH) {
+            if (switch_cost <= 0 || (seg.finish - seg.start) % switch_cost) return failure("switch at segment %d", s);
+            continue;
+        }
+        if (seg.pid == GANTT_PID_WARMUP) {
+            if (resume_penalty <= 0) return failure("warm-up at segment %d without a resume_penalty", s);
+            continue;
+        }
+        if (seg.pid == GANTT_PID_IDLE) continue;
+        if (seg.pid < 1 || seg.pid > n) return failure("pid %d at segment %d", seg.pid, s);
+        int i = index[seg.pid];
+        if (seg.start < c.procs[i].at) return failure("P%d runs before its arrival", seg.pid);
+        ran[i] += seg.finish - seg.start;
+        last_finish[i] = seg.finish;
+    }
+    for (int i = 0; i < n; i++) {
+        const Process& p = out.procs[i];
+        if (ran[i] != cpu_time[i] || p.bt != cpu_time[i]) {
+            return failure("P%d ran %lld and reports bt %d of %lld", p.pid, ran[i], p.bt, cpu_time[i]);
+        }
+        if (cpu_time[i] > 0 && p.ct != last_finish[i]) {
+            return failure("P%d ct %d, last ran until %d", p.pid, p.ct, last_finish[i]);
+        }
+        if (p.tat != p.ct - p.at || p.wt < 0 || p.tat - p.wt < p.bt) return failure("P%d times", p.pid);
+    }
+    return "";
+}
+
+static std::vector<long long> burst_times(const Case& c) {
+    std::vector<long long> cpu_time;
+    for (const Process& p : c.procs) cpu_time.push_back(p.bt);
+    return cpu_time;
+}
+
+// Random scheduler parameters, including MLFQ level counts and context-switch overhead.
+// quanta holds the mlfq_quanta the config points to.
+static SchedulerConfig random_config(std::mt19937& rng, std::vector<int>& quanta) {
+    SchedulerConfig config = {};
+    config.aging_rate = (int)(rng() % 8);
+    config.mlfq_levels = (int)(rng() % 7);
+    quanta.resize(std::max(0, config.mlfq_levels - 1));
+    for (int& q : quanta) q = 1 + (int)(rng() % 20);
+    config.mlfq_quanta = rng() % 3 ? quanta.data() : nullptr;
+    config.promotion_threshold = (int)(rng() % 60);
+    config.mlq_q2_quantum = (int)(rng() % 12);
+    config.switch_cost = rng() % 2 ? (int)(rng() % 4) : 0;
+    config.resume_penalty = rng() % 2 ? (int)(rng() % 3) : 0;
+    return config;
+}
+
+// Under random parameters the total fits scheduler_config_log_bound, a buffer of the bound
+// receives all of it, and the timeline runs every process for bt ticks.
+static std::string check_config_bound(const Case& c) {
+    std::mt19937 rng(c.check_seed);
+    std::vector<int> quanta;
+    SchedulerConfig config = random_config(rng, quanta);
+    int n = (int)c.procs.size();
+    int bound = scheduler_config_log_bound(c.procs.data(), n, c.code, c.quantum, &config);
+    std::vector<Process> procs = c.procs;
+    int total = run_scheduler_config(procs.data(), n, c.code, c.quantum, &config, nullptr, 0, flags_of(c));
+    if (total > bound) return failure("%d segments, scheduler_config_log_bound %d", total, bound);
+    Outcome out = run_config(c, &config, std::max(1, bound));
+    if (out.count != total) return failure("stored %d of %d segments with a buffer of the bound", out.count, total);
+    return timeline_failure(c, out, burst_times(c), config.switch_cost, config.resume_penalty);
+}
+
+static void append_segments(const GanttLog* segments, int count, void* user) {
+    std::vector<GanttLog>* out = static_cast<std::vector<GanttLog>*>(user);
+    out->insert(out->end(), segments, segments + count);
+}
+
+// Streaming in chunks of chunk_capacity delivers the whole timeline of run_scheduler_ex.
+static std::string check_stream(const Case& c) {
+    Outcome streamed{c.procs, {}, 0};
+    std::vector<GanttLog> chunk(c.chunk_capacity);
+    streamed.count = run_scheduler_stream(streamed.procs.data(), (int)c.procs.size(), c.code, c.quantum,
+                                          flags_of(c), chunk.data(), c.chunk_capacity,
+                                          append_segments, &streamed.logs, nullptr);
+    if (streamed.count != (int)streamed.logs.size()) {
+        return failure("returned %d segments, delivered %zu", streamed.count, streamed.logs.size());
+    }
+    int bound = std::max(1, scheduler_log_bound(c.procs.data(), (int)c.procs.size(), c.code, c.quantum));
+    return first_difference(streamed, run_config(c, nullptr, bound), "run_scheduler_config");
+}
+
+static Outcome run_io(const Case& c, const IoPlan& plan, int max_logs) {
+    Outcome out{c.procs, std::vector<GanttLog>(max_logs), 0};
+    out.count = run_scheduler_io(out.procs.data(), (int)out.procs.size(), c.code, c.quantum, nullptr, &plan,
+                                 out.logs.data(), max_logs, flags_of(c));
+    return out;
+}
+
+// Plans without I/O run exactly like run_scheduler_config; malformed plans are rejected;
+// a random plan runs every CPU burst in full after its arrival, within scheduler_io_log_bound.
+static std::string check_io(const Case& c) {
+    int n = (int)c.procs.size();
+    Outcome expected = run_config(c, nullptr, c.max_logs);
+    std::vector<int> empty(n + 1, 0);
+    std::vector<int> offsets(n + 1), bursts(n);
+    for (int i = 0; i < n; i++) {
+        offsets[i + 1] = i + 1;
+        bursts[i] = c.procs[i].bt;
+    }
+    IoPlan no_io = {empty.data(), nullptr, nullptr, 0};
+    std::string diff = first_difference(run_io(c, no_io, c.max_logs), expected, "run_scheduler_config");
+    if (!diff.empty()) return "empty plan: " + diff;
+    IoPlan single = {offsets.data(), bursts.data(), nullptr, 0};
+    diff = first_difference(run_io(c, single, c.max_logs), expected, "run_scheduler_config");
+    if (!diff.empty()) return "single bursts: " + diff;
+
+    std::vector<Process> procs = c.procs;
+    IoPlan no_bursts = {offsets.data(), nullptr, nullptr, 0};
+    if (run_scheduler_io(procs.data(), n, c.code, c.quantum, nullptr, &no_bursts, nullptr, 0, 0) != -1 ||
+        scheduler_io_log_bound(procs.data(), n, c.code, c.quantum, nullptr, &no_bursts) != -1) {
+        return "accepted a plan with bursts NULL";
+    }
+    bursts[0] = -1;
+    if (run_scheduler_io(procs.data(), n, c.code, c.quantum, nullptr, &single, nullptr, 0, 0) != -1 ||
+        scheduler_io_log_bound(procs.data(), n, c.code, c.quantum, nullptr, &single) != -1) {
+        return "accepted a negative lone burst";
+    }
+
+    std::mt19937 rng(c.check_seed);
+    int num_devices = 1 + (int)(rng() % 3);
+    std::vector<int> devices;
+    std::vector<long long> cpu_time(n, 0);
+    bursts.clear();
+    for (int i = 0; i < n; i++) {
+        int count = 2 * (int)(rng() % 3) + 1;
+        for (int k = 0; k < count; k++) {
+            bool cpu = k % 2 == 0;
+            bursts.push_back(cpu ? 1 + (int)(rng() % 10) : (int)(rng() % 10));
+            devices.push_back((int)(rng() % num_devices));
+            if (cpu) cpu_time[i] += bursts.back();
+        }
+        offsets[i + 1] = (int)bursts.size();
+    }
+    IoPlan plan = {offsets.data(), bursts.data(), devices.data(), num_devices};
+    int bound = scheduler_io_log_bound(c.procs.data(), n, c.code, c.quantum, nullptr, &plan);
+    procs = c.procs;
+    int total = run_scheduler_io(procs.data(), n, c.code, c.quantum, nullptr, &plan, nullptr, 0, 0);
+    if (total < 0 || total > bound) return failure("random plan: %d segments, scheduler_io_log_bound %d", total, bound);
+    Outcome out = run_io(c, plan, std::max(1, bound));
+    if (out.count != total) return failure("random plan: stored %d of %d segments", out.count, total);
+    diff = timeline_failure(c, out, cpu_time);
+    return diff.empty() ? "" : "random plan: " + diff;
+}
+
+// SMP runs on random CPU counts, balancing modes, affinities and overheads: the total fits
+// scheduler_smp_config_log_bound, no CPU runs two segments at once and no process runs on
+// two CPUs at once, every process runs for bt ticks after its arrival on the CPU it is
+// pinned to, and ct/tat match its timeline. MLFQ and MLQ are rejected.
+static std::string check_smp(const Case& c) {
+    std::mt19937 rng(c.check_seed);
+    int n = (int)c.procs.size();
+    std::vector<int> affinity(n);
+    SmpConfig smp = {};
+    smp.num_cpus = 1 + (int)(rng() % 4);
+    smp.balance = (int)(rng() % 3);
+    for (int& cpu : affinity) cpu = rng() % 3 == 0 ? (int)(rng() % smp.num_cpus) : -1;
+    smp.affinity = rng() % 2 ? affinity.data() : nullptr;
+    if (rng() % 2) {
+        smp.switch_cost = (int)(rng() % 3);
+        smp.resume_penalty = (int)(rng() % 3);
+        smp.migration_penalty = (int)(rng() % 4);
+    }
+    std::vector<Process> procs = c.procs;
+    int total = run_scheduler_smp(procs.data(), n, c.code, c.quantum, &smp, nullptr, 0, flags_of(c));
+    if (c.code >= 6) return total == -1 ? "" : failure("returned %d instead of -1", total);
+    int bound = scheduler_smp_config_log_bound(c.procs.data(), n, c.code, c.quantum, &smp);
+    if (total < 0 || total > bound) return failure("%d segments, scheduler_smp_config_log_bound %d", total, bound);
+    std::vector<SmpGanttLog> logs(std::max(1, bound));
+    procs = c.procs;
+    int count = run_scheduler_smp(procs.data(), n, c.code, c.quantum, &smp, logs.data(), bound, flags_of(c));
+    if (count != total) return failure("stored %d of %d segments with a buffer of the bound", count, total);
+    logs.resize(count);
+
+    std::vector<int> index(n + 1);
+    for (int i = 0; i < n; i++) index[c.procs[i].pid] = i;
+    std::vector<long long> ran(n, 0);
+    std::vector<int> last_finish(n, -1);
+    std::vector<std::vector<SmpGanttLog>> per_cpu(smp.num_cpus), per_process(n);
+    for (const SmpGanttLog& seg : logs) {
+        if (seg.cpu < 0 || seg.cpu >= smp.num_cpus || seg.finish <= seg.start) {
+            return failure("segment %d:[%d, %d) on CPU %d", seg.pid, seg.start, seg.finish, seg.cpu);
+        }
+        per_cpu[seg.cpu].push_back(seg);
+        if (seg.pid <= 0) continue;
+        int i = index[seg.pid];
+        if (seg.start < c.procs[i].at) return failure("P%d runs before its arrival", seg.pid);
+        if (smp.affinity && affinity[i] >= 0 && seg.cpu != affinity[i]) {
+            return failure("P%d pinned to CPU %d runs on CPU %d", seg.pid, affinity[i], seg.cpu);
+        }
+        ran[i] += seg.finish - seg.start;
+        last_finish[i] = std::max(last_finish[i], seg.finish);
+        per_process[i].push_back(seg);
+    }
+    for (std::vector<std::vector<SmpGanttLog>>* groups : {&per_cpu, &per_process}) {
+        for (std::vector<SmpGanttLog>& group : *groups) {
+            std::sort(group.begin(), group.end(), [](const SmpGanttLog& a, const SmpGanttLog& b) { return a.start < b.start; });
+            for (size_t k = 1; k < group.size(); k++) {
+                if (group[k].start < group[k - 1].finish) {
+                    return failure("%d:[%d, %d) on CPU %d overlaps %d:[%d, %d) on CPU %d", group[k].pid, group[k].start,
+                                   group[k].finish, group[k].cpu, group[k - 1].pid, group[k - 1].start,
+                                   group[k - 1].finish, group[k - 1].cpu);
+                }
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        const Process& p = procs[i];
+        if (ran[i] != c.procs[i].bt) return failure("P%d ran %lld of %d", p.pid, ran[i], c.procs[i].bt);
+        if (p.ct != last_finish[i] || p.tat != p.ct - p.at || p.wt != p.tat - p.bt) {
+            return failure("P%d ct %d tat %d wt %d, last ran until %d", p.pid, p.ct, p.tat, p.wt, last_finish[i]);
+        }
+    }
+    return "";
+}
+
+// One context runs another workload, then the case, then the case again after a reset,
+// and every run of the case matches run_scheduler_config with the same config.
+static std::string check_context(const Case& c) {
+    std::mt19937 rng(c.check_seed);
+    std::vector<int> quanta;
+    SchedulerConfig config = random_config(rng, quanta);
+    const SchedulerConfig* cfg = rng() % 2 ? &config : nullptr;
+    Outcome expected = run_config(c, cfg, c.max_logs);
+    std::unique_ptr<SchedulerContext, void (*)(SchedulerContext*)> ctx(scheduler_context_create(),
+                                                                       scheduler_context_destroy);
+    std::vector<Process> other;
+    int other_n = 1 + (int)(rng() % 64);
+    for (int i = 0; i < other_n; i++) {
+        other.push_back(make_process(i + 1, (int)(rng() % 100), 1 + (int)(rng() % 20), 1 + (int)(rng() % 3)));
+    }
+    std::vector<GanttLog> other_logs(1 + rng() % 100);
+    for (int run = 0; run < 3; run++) {
+        if (run == 0) {
+            run_scheduler_context(ctx.get(), other.data(), other_n, (int)(rng() % 8), 1 + (int)(rng() % 8), nullptr,
+                                  other_logs.data(), (int)other_logs.size(), 0);
+        }
+        if (run == 2) scheduler_context_reset(ctx.get());
+        Outcome out{c.procs, std::vector<GanttLog>(c.max_logs), 0};
+        out.count = run_scheduler_context(ctx.get(), out.procs.data(), (int)c.procs.size(), c.code, c.quantum, cfg,
+                                          out.logs.data(), c.max_logs, flags_of(c));
+        std::string diff = first_difference(out, expected, "run_scheduler_config");
+        if (!diff.empty()) return failure("run %d: %s", run, diff.c_str());
+    }
+    return "";
+}
+
+// The same case under another algorithm_code and quantum, e.g. for a batch job.
+static Case with_algorithm(const Case& c, int code, int quantum) {
+    Case other = c;
+    other.code = code;
+    other.quantum = quantum;
+    return other;
+}
+
+// A batch over the case: job 0 runs the case as it is, the others another algorithm_code
+// and quantum under a random config. Every job writes its own logs and results.
+struct Batch {
+    static constexpr int kJobs = 3;
+    Case cases[kJobs];
+    std::vector<int> quanta[kJobs];
+    SchedulerConfig configs[kJobs];
+    Outcome outcomes[kJobs];
+    BatchJob jobs[kJobs];
+    BatchResult results[kJobs];
+
+    explicit Batch(const Case& c) {
+        std::mt19937 rng(c.check_seed);
+        for (int j = 0; j < kJobs; j++) {
+            configs[j] = random_config(rng, quanta[j]);
+            cases[j] = j == 0 ? c : with_algorithm(c, (int)(rng() % 8), 1 + (int)(rng() % 8));
+            outcomes[j] = {c.procs, std::vector<GanttLog>(c.max_logs), 0};
+            jobs[j] = {cases[j].code, cases[j].quantum, nullptr, outcomes[j].logs.data(), c.max_logs,
+                       outcomes[j].procs.data(), j == 0 ? nullptr : &configs[j]};
+        }
+    }
+    Batch(const Batch&) = delete;
+    Batch& operator=(const Batch&) = delete;
+
+    int run(const Case& c) {
+        return run_scheduler_batch(c.procs.data(), (int)c.procs.size(), jobs, kJobs, results, flags_of(c));
+    }
+};
+
+static bool close_to(double a, double b) {
+    return std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(b));
+}
+
+// Every job of a batch writes what its own run_scheduler_config does, and its BatchResult
+// matches that timeline: segments, makespan, idle, switch and warm-up time, mean tat/wt/rt.
+static std::string check_batch(const Case& c) {
+    int n = (int)c.procs.size();
+    Batch batch(c);
+    if (batch.run(c) != Batch::kJobs) return "the batch did not run every job";
+    for (int j = 0; j < Batch::kJobs; j++) {
+        const BatchJob& job = batch.jobs[j];
+        int bound = std::max(1, scheduler_job_log_bound(c.procs.data(), n, &job));
+        Outcome full = run_config(batch.cases[j], job.config, bound);
+        Outcome& out = batch.outcomes[j];
+        out.count = std::min(c.max_logs, full.count);
+        std::string diff = first_difference(out, run_config(batch.cases[j], job.config, c.max_logs),
+                                            "run_scheduler_config");
+        if (!diff.empty()) return failure("job %d: %s", j, diff.c_str());
+
+        int makespan = 0, idle = 0, switching = 0, warmup = 0;
+        double tat = 0.0, wt = 0.0, rt = 0.0;
+        for (const Process& p : full.procs) {
+            makespan = std::max(makespan, p.ct);
+            tat += p.tat;
+            wt += p.wt;
+            rt += p.first_run - p.at;
+        }
+        for (int s = 0; s < full.count; s++) {
+            const GanttLog& seg = full.logs[s];
+            int length = seg.finish - seg.start;
+            if (seg.pid == GANTT_PID_IDLE) idle += length;
+            else if (seg.pid == GANTT_PID_SWITCH) switching += length;
+            else if (seg.pid == GANTT_PID_WARMUP) warmup += length;
+        }
+        const BatchResult& r = batch.results[j];
+        if (r.segments != full.count || r.makespan != makespan || r.idle_time != idle || r.switch_time != switching ||
+            r.warmup_time != warmup || !close_to(r.avg_tat, tat / n) || !close_to(r.avg_wt, wt / n) ||
+            !close_to(r.avg_rt, rt / n)) {
+            return failure("job %d: BatchResult does not match the timeline of %d segments", j, full.count);
+        }
+    }
+    return "";
+}
+
+static bool same_result(const BatchResult& a, const BatchResult& b) {
+    return a.segments == b.segments && a.makespan == b.makespan && a.idle_time == b.idle_time &&
+           a.context_switches == b.context_switches && a.avg_tat == b.avg_tat && a.avg_wt == b.avg_wt &&
+           a.avg_rt == b.avg_rt && a.switch_time == b.switch_time && a.warmup_time == b.warmup_time;
+}
+
+// run_scheduler_batch_mt on 1-3 workers writes exactly what run_scheduler_batch does.
+static std::string check_batch_mt(const Case& c) {
+    Batch batch(c), threaded(c);
+    int workers = 1 + (int)(c.check_seed % 3);
+    if (batch.run(c) != Batch::kJobs ||
+        run_scheduler_batch_mt(c.procs.data(), (int)c.procs.size(), threaded.jobs, Batch::kJobs, threaded.results,
+                               flags_of(c), workers) != Batch::kJobs) {
+        return "a batch did not run every job";
+    }
+    for (int j = 0; j < Batch::kJobs; j++) {
+        int stored = std::min(c.max_logs, batch.results[j].segments);
+        batch.outcomes[j].count = threaded.outcomes[j].count = stored;
+        std::string diff = first_difference(threaded.outcomes[j], batch.outcomes[j], "run_scheduler_batch");
+        if (!diff.empty()) return failure("job %d on %d workers: %s", j, workers, diff.c_str());
+        if (!same_result(threaded.results[j], batch.results[j])) {
+            return failure("job %d on %d workers: the BatchResult differs", j, workers);
+        }
+    }
+    return "";
+}
+
+static bool same_summary(const MetricSummary& a, const MetricSummary& b) {
+    return a.mean == b.mean && a.p50 == b.p50 && a.p95 == b.p95 && a.p99 == b.p99 && a.max == b.max;
+}
+
+// Field by field: the structs have padding
+static bool same_metrics(const SchedulerMetrics& a, const SchedulerMetrics& b) {
+    return a.processes == b.processes && a.segments == b.segments && a.makespan == b.makespan &&
+           a.idle_time == b.idle_time && a.context_switches == b.context_switches && a.switch_time == b.switch_time &&
+           a.warmup_time == b.warmup_time && a.utilization == b.utilization && a.throughput == b.throughput &&
+           same_summary(a.wt, b.wt) && same_summary(a.tat, b.tat) && same_summary(a.rt, b.rt);
+}
+
+// run_scheduler_metrics_batch agrees with the BatchResult of every job, and
+// run_scheduler_metrics with the metrics batch.
+static std::string check_metrics(const Case& c) {
+    int n = (int)c.procs.size();
+    Batch batch(c);
+    SchedulerMetrics metrics[Batch::kJobs];
+    int workers = 1 + (int)(c.check_seed % 3);
+    if (batch.run(c) != Batch::kJobs ||
+        run_scheduler_metrics_batch(c.procs.data(), n, batch.jobs, Batch::kJobs, metrics, flags_of(c), workers) !=
+            Batch::kJobs) {
+        return "a batch did not run every job";
+    }
+    for (int j = 0; j < Batch::kJobs; j++) {
+        const BatchJob& job = batch.jobs[j];
+        const BatchResult& r = batch.results[j];
+        const SchedulerMetrics& m = metrics[j];
+        if (m.processes != n || m.segments != r.segments || m.makespan != r.makespan || m.idle_time != r.idle_time ||
+            m.context_switches != r.context_switches || m.switch_time != r.switch_time ||
+            m.warmup_time != r.warmup_time || !close_to(m.tat.mean, r.avg_tat) || !close_to(m.wt.mean, r.avg_wt) ||
+            !close_to(m.rt.mean, r.avg_rt)) {
+            return failure("job %d: metrics differ from the BatchResult", j);
+        }
+        SchedulerMetrics single;
+        if (run_scheduler_metrics(c.procs.data(), n, job.algorithm_code, job.quantum, job.config, &single,
+                                  flags_of(c)) != 0 ||
+            !same_metrics(single, m)) {
+            return failure("job %d: run_scheduler_metrics differs from run_scheduler_metrics_batch", j);
+        }
+    }
+    return "";
+}
+
+// Submitting the case in arrival order to a session, advancing to random times and
+// draining in chunks, then closing, yields run_scheduler_config's segments and results.
+static std::string check_session(const Case& c) {
+    std::mt19937 rng(c.check_seed);
+    std::vector<int> quanta;
+    SchedulerConfig config = random_config(rng, quanta);
+    const SchedulerConfig* cfg = rng() % 2 ? &config : nullptr;
+    // Sessions number processes by submission, so compare with the input in that order
+    Case sorted = c;
+    std::stable_sort(sorted.procs.begin(), sorted.procs.end(), [](const Process& a, const Process& b) { return a.at < b.at; });
+    int n = (int)sorted.procs.size();
+    for (int i = 0; i < n; i++) sorted.procs[i].pid = i + 1;
+    int bound = std::max(1, scheduler_config_log_bound(sorted.procs.data(), n, c.code, c.quantum, cfg));
+    Outcome expected = run_config(sorted, cfg, bound);
+
+    std::unique_ptr<SchedulerSession, void (*)(SchedulerSession*)> session(
+        scheduler_session_create(c.code, c.quantum, cfg), scheduler_session_destroy);
+    Outcome out{sorted.procs, {}, 0};
+    std::vector<GanttLog> chunk(c.chunk_capacity);
+    std::vector<Process> completed(c.chunk_capacity);
+    std::vector<int> completions(n, 0);
+    auto drain = [&] {
+        int count;
+        while ((count = scheduler_session_drain_segments(session.get(), chunk.data(), c.chunk_capacity)) > 0) {
+            out.logs.insert(out.logs.end(), chunk.begin(), chunk.begin() + count);
+        }
+        while ((count = scheduler_session_drain_completions(session.get(), completed.data(), c.chunk_capacity)) > 0) {
+            for (int k = 0; k < count; k++) {
+                int i = completed[k].pid - 1;
+                if (i < 0 || i >= n) continue;
+                out.procs[i] = completed[k];
+                completions[i]++;
+            }
+        }
+    };
+    int advanced = 0;
+    for (int i = 0; i < n; i++) {
+        const Process& p = sorted.procs[i];
+        int pid = scheduler_session_submit(session.get(), p.at, p.bt, p.priority);
+        if (pid != i + 1) return failure("submission %d returned pid %d", i + 1, pid);
+        int next = i + 1 < n ? sorted.procs[i + 1].at : p.at + 50;
+        if (rng() % 3 == 0) {
+            advanced = p.at + (int)(rng() % (next - p.at + 1));
+            scheduler_session_advance(session.get(), advanced);
+            drain();
+        }
+    }
+    if (advanced > 0 && scheduler_session_submit(session.get(), advanced - 1, 1, 1) != -1) {
+        return failure("accepted a submission arriving before the session time %d", advanced);
+    }
+    scheduler_session_close(session.get());
+    drain();
+    if (scheduler_session_submit(session.get(), advanced + 100, 1, 1) != -1) return "accepted a submission after close";
+    for (int i = 0; i < n; i++) {
+        if (completions[i] != 1) return failure("P%d completed %d times", i + 1, completions[i]);
+    }
+    out.count = (int)out.logs.size();
+    return first_difference(out, expected, "run_scheduler_config");
+}
+
+// Busy ticks of the timeline within [t0, t1).
+static long long busy_in(const Outcome& out, int t0, int t1) {
+    long long busy = 0;
+    for (int s = 0; s < out.count; s++) {
+        const GanttLog& seg = out.logs[s];
+        if (seg.pid > 0) busy += std::max(0, std::min(seg.finish, t1) - std::max(seg.start, t0));
+    }
+    return busy;
+}
+
+// LOD views of random ranges at random widths tile the range in order with at most
+// pixels + 2 entries and keep the exact busy time; a view with room for every segment
+// returns them as they are.
+static std::string check_lod(const Case& c) {
+    std::mt19937 rng(c.check_seed);
+    std::vector<int> quanta;
+    SchedulerConfig config = random_config(rng, quanta);
+    int bound = std::max(1, scheduler_config_log_bound(c.procs.data(), (int)c.procs.size(), c.code, c.quantum, &config));
+    Outcome timeline = run_config(c, &config, bound);
+    std::unique_ptr<GanttLod, void (*)(GanttLod*)> lod(gantt_lod_create(timeline.logs.data(), timeline.count),
+                                                     gantt_lod_destroy);
+    if (!lod) return "gantt_lod_create rejected a single-CPU timeline";
+    int end = timeline.logs[timeline.count - 1].finish;
+    for (int view = 0; view < 8; view++) {
+        int t0 = (int)(rng() % end);
+        int t1 = t0 + 1 + (int)(rng() % (end - t0));
+        int pixels = 1 + (int)(rng() % (view < 4 ? 8 : 200));
+        std::vector<GanttLodSegment> out(pixels + 2);
+        int count = gantt_lod_query(lod.get(), t0, t1, pixels, out.data(), (int)out.size());
+        if (count < 1 || count > pixels + 2) return failure("[%d, %d) at %d pixels: %d entries", t0, t1, pixels, count);
+        long long busy = 0;
+        int time = t0;
+        for (int k = 0; k < count; k++) {
+            if (out[k].start != time || out[k].finish <= out[k].start || out[k].busy < 0 ||
+                out[k].busy > out[k].finish - out[k].start) {
+                return failure("[%d, %d) at %d pixels: entry %d is %d:[%d, %d) busy %d", t0, t1, pixels, k, out[k].pid,
+                               out[k].start, out[k].finish, out[k].busy);
+            }
+            time = out[k].finish;
+            busy += out[k].busy;
+        }
+        if (time != t1) return failure("[%d, %d) at %d pixels: the view ends at %d", t0, t1, pixels, time);
+        if (busy != busy_in(timeline, t0, t1)) {
+            return failure("[%d, %d) at %d pixels: busy %lld, timeline %lld", t0, t1, pixels, busy, busy_in(timeline, t0, t1));
+        }
+        // With room for every segment in range the view is the clipped timeline
+        std::vector<GanttLodSegment> raw(timeline.count);
+        count = gantt_lod_query(lod.get(), t0, t1, timeline.count, raw.data(), timeline.count);
+        int k = 0;
+        for (int s = 0; s < timeline.count; s++) {
+            const GanttLog& seg = timeline.logs[s];
+            if (seg.finish <= t0 || seg.start >= t1) continue;
+            int start = std::max(seg.start, t0), finish = std::min(seg.finish, t1);
+            if (k >= count || raw[k].pid != seg.pid || raw[k].start != start || raw[k].finish != finish) {
+                return failure("[%d, %d) unreduced: entry %d differs from segment %d", t0, t1, k, s);
+            }
+            k++;
+        }
+        if (k != count) return failure("[%d, %d) unreduced: %d entries for %d segments", t0, t1, count, k);
+    }
+    return "";
+}
+
+struct Suite {
+    const char* name;
+    CaseCheck check;
+};
+static const Suite kSuites[] = {
+    {"reference", check_reference},
+    {"config", check_config},
+    {"bound", check_bound},
+    {"config_bound", check_config_bound},
+    {"stream", check_stream},
+    {"io", check_io},
+    {"smp", check_smp},
+    {"context", check_context},
+    {"batch", check_batch},
+    {"batch_mt", check_batch_mt},
+    {"metrics", check_metrics},
+    {"session", check_session},
+    {"lod", check_lod},
+};
+
+// --- Speedup ---
+typedef std::chrono::steady_clock Clock;
+
+// Seconds per run_fn call, repeated until min_time has elapsed (at least once).
+template <typename RunFn>
+static double time_runs(const Options& opt, RunFn run_fn) {
+    long long iterations = 0;
+    double elapsed = 0.0;
+    while (iterations == 0 || elapsed < opt.min_time) {
+        Clock::time_point start = Clock::now();
+        run_fn();
+        elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+        iterations++;
+    }
+    return elapsed / iterations;
+}
+
+static void report_speedup(const Options& opt) {
+    std::printf("\n%-8s %8s %14s %14s %9s\n", "algo", "n", "reference ms", "engine ms", "speedup");
+    for (int code = 0; code < 8; code++) {
+        if (opt.algo != -1 && code != opt.algo) continue;
+        std::mt19937 rng(opt.seed);
+        std::vector<Process> input(opt.speed_n);
+        for (int i = 0; i < opt.speed_n; i++) {
+            int priority = code == 7 ? 1 + (int)(rng() % 3) : 1 + (int)(rng() % 10);
+            input[i] = make_process(i + 1, (int)(rng() % (opt.speed_n * 4 + 1)), 1 + (int)(rng() % 20), priority);
+        }
+        int max_logs = std::max(1, scheduler_log_bound(input.data(), opt.speed_n, code, 4));
+        std::vector<Process> procs;
+        std::vector<GanttLog> logs(max_logs);
+        double ref = time_runs(opt, [&] {
+            procs = input;
+            run_scheduler_reference(procs.data(), opt.speed_n, code, 4, logs.data(), max_logs);
+        });
+        double engine = time_runs(opt, [&] {
+            procs = input;
+            run_scheduler(procs.data(), opt.speed_n, code, 4, logs.data(), max_logs);
+        });
+        std::printf("%-8s %8d %14.3f %14.3f %8.1fx\n", kAlgoNames[code], opt.speed_n, ref * 1e3, engine * 1e3,
+                    ref / engine);
+    }
+}
+
+static bool parse_options(int argc, char** argv, Options& opt) {
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        const char* value = k + 1 < argc ? argv[k + 1] : nullptr;
+        if (arg == "--suite" && value) opt.suite = value;
+        else if (arg == "--cases" && value) opt.cases = std::atoi(value);
+        else if (arg == "--seed" && value) opt.seed = (unsigned)std::strtoul(value, nullptr, 10);
+        else if (arg == "--algo" && value) opt.algo = std::atoi(value);
+        else if (arg == "--case" && value) opt.replay = std::atoi(value);
+        else if (arg == "--speed-n" && value) opt.speed_n = std::atoi(value);
+        else if (arg == "--min-time" && value) opt.min_time = std::atof(value);
+        else return false;
+        k++;
+    }
+    return opt.algo >= -1 && opt.algo < 8;
+}
+
+static const Suite* find_suite(const std::string& name) {
+    for (const Suite& suite : kSuites) {
+        if (name == suite.name) return &suite;
+    }
+    return nullptr;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    const Suite* suite = nullptr;
+    if (!parse_options(argc, argv, opt) || !(suite = find_suite(opt.suite))) {
+        std::fprintf(stderr, "usage: %s [--suite NAME] [--cases N] [--seed S] [--algo CODE] [--case K] "
+                             "[--speed-n N] [--min-time SEC]\n  suites:", argv[0]);
+        for (const Suite& s : kSuites) std::fprintf(stderr, " %s", s.name);
+        std::fprintf(stderr, "\n");
+        return 2;
+    }
+    bool reference = suite->check == check_reference;
+
+    if (opt.replay >= 0) {
+        Case c = make_case(opt, opt.replay);
+        std::string diff = suite->check(c);
+        std::printf("%s case %d (seed %u): %s\n", suite->name, opt.replay, opt.seed, diff.empty() ? "match" : diff.c_str());
+        if (reference) print_case(c, run_engine(c), run_reference(c));
+        else print_workload(c);
+        return diff.empty() ? 0 : 1;
+    }
+
+    int failures = 0;
+    int per_code[8] = {0};
+    for (int k = 0; k < opt.cases; k++) {
+        Case c = make_case(opt, k);
+        per_code[c.code]++;
+        std::string diff = suite->check(c);
+        if (diff.empty()) continue;
+        if (failures++ < 10) {
+            std::printf("case %d: %s %s (replay with --suite %s --seed %u%s --case %d)\n", k, kAlgoNames[c.code],
+                        diff.c_str(), suite->name, opt.seed,
+                        opt.algo >= 0 ? (" --algo " + std::to_string(opt.algo)).c_str() : "", k);
+        }
+    }
+    std::printf("%s: %d/%d cases %s (", suite->name, failures, opt.cases, reference ? "differ" : "fail");
+    for (int code = 0; code < 8; code++) std::printf("%s%s %d", code ? ", " : "", kAlgoNames[code], per_code[code]);
+    std::printf(")\n");
+
+    if (reference && opt.speed_n > 0) report_speedup(opt);
+    return failures ? 1 : 0;
+}
@@ -1,7 +1,61 @@
 #include <vector>
 #include <algorithm>
 #include <iostream>
-#include <map>
+#include <climits>
+#include <atomic>
+#include <thread>
+#include <system_error>
+#include <new>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX // Keeps std::min/std::max usable
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#include <arm_neon.h>
+#define SCHED_USE_NEON 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(SCHEDULER_INSTRUMENT)
+#include <chrono>
+#include <cstdio>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SCHED_PROFILE_TSC 1
+#if !defined(_MSC_VER)
+#include <x86intrin.h>
+#endif
+#endif
+#endif
+
+// Marks the extern "C" entry points exported from the shared library on every platform
+#if defined(_WIN32) || defined(__CYGWIN__)
+#define SCHEDULER_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#define SCHEDULER_API __attribute__((visibility("default")))
+#else
+#define SCHEDULER_API
+#endif
 
 // Define standard C structures to match Python
 struct Process {
@@ -28,6 +82,15 @@ struct GanttLog {
     int finish;
 };
 
+// Gantt pids of the non-process segments. Overhead segments only appear when a switch
+// cost or warm-up penalty is configured.
+#define GANTT_PID_IDLE -1
+#define GANTT_PID_SWITCH -2    // Context switch into the next process
+#define GANTT_PID_WARMUP -3    // Cache warm-up of a process resuming on the CPU it last ran on
+#define GANTT_PID_MIGRATION -4 // Cache warm-up of a process resuming on another CPU (SMP)
+
+// Default parameters; SchedulerConfig overrides them per run
+
 // Global definition for aging rate (used for Priority P/NP)
 #define PRIORITY_AGING_RATE 5 
 
@@ -39,494 +102,3404 @@ struct GanttLog {
 // MLQ Parameters
 #define MLQ_Q2_QUANTUM 10
 
-extern "C" {
-__declspec(dllexport) int run_scheduler(
-    Process* procs,
-    int n,
-    int algorithm_code,
-    int quantum, 
-    GanttLog* logs,
-    int max_logs
-) {
-    std::vector<Process> queue;
-    for(int i=0; i<n; i++) {
-        procs[i].rem_time = procs[i].bt;
-        procs[i].first_run = -1; 
-        procs[i].base_priority = procs[i].priority;
-        procs[i].current_priority = procs[i].priority;
-        
-        // MLFQ / MLQ Initialization
-        if (algorithm_code == 6) {
-            procs[i].current_queue = 1; // MLFQ: Start in Q1
-        } else if (algorithm_code == 7) {
-            // MLQ: The target queue ID (1, 2, or 3) is passed in the initial 'priority' field.
-            procs[i].current_queue = procs[i].priority; 
-        } else {
-            procs[i].current_queue = -1; 
+// Runtime overrides for the parameters above. A NULL config, or any field <= 0, keeps the
+// default. mlfq_quanta lists the round robin quanta of the mlfq_levels - 1 upper levels
+// (top first); the last level is always FCFS. Without it the quanta start at Q1_QUANTUM
+// and double per level.
+struct SchedulerConfig {
+    int aging_rate;          // Ticks of waiting per priority step (Priority P/NP)
+    int mlfq_levels;         // MLFQ queue count, including the FCFS level
+    const int* mlfq_quanta;  // mlfq_levels - 1 entries, or NULL
+    int promotion_threshold; // Wait in the MLFQ FCFS level before moving up one level
+    int mlq_q2_quantum;      // MLQ Q2 round robin quantum
+    int switch_cost;         // Ticks to switch the CPU to a different process (default 0)
+    int resume_penalty;      // Warm-up ticks for a preempted process resuming after another ran (default 0)
+};
+
+// run_scheduler_ex flags
+#define SCHED_FLAG_PRESORTED 1 // Input is already sorted by arrival time; skip the arrival sort
+
+// CPU/I/O burst sequences for run_scheduler_io. Process i alternates CPU and I/O bursts
+// bursts[offsets[i]] .. bursts[offsets[i + 1] - 1]: CPU, I/O, CPU, ..., CPU, an odd count
+// with every CPU burst > 0 (a lone CPU burst may be 0, like bt). An empty range keeps the
+// single CPU burst bt. devices lists the device (0 .. num_devices - 1) serving the I/O
+// burst at the same position, and is ignored at CPU positions; NULL serves every I/O
+// burst on device 0. Each device serves one request at a time, first come first served.
+struct IoPlan {
+    const int* offsets; // n + 1 ascending positions into bursts
+    const int* bursts;
+    const int* devices; // Same length as bursts, or NULL
+    int num_devices;    // <= 0 means 1
+};
+
+// Validated parameters for one run, built from an optional SchedulerConfig.
+struct SchedParams {
+    int aging_rate = PRIORITY_AGING_RATE;
+    std::vector<int> mlfq_quanta = {Q1_QUANTUM, Q2_QUANTUM}; // RR levels; the FCFS level follows
+    int promotion_threshold = Q3_PROMOTION_THRESHOLD;
+    int mlq_q2_quantum = MLQ_Q2_QUANTUM;
+    int switch_cost = 0;
+    int resume_penalty = 0;
+
+    explicit SchedParams(const SchedulerConfig* config) { configure(config); }
+
+    // Re-applies the defaults and config in place, reusing the quanta storage.
+    void configure(const SchedulerConfig* config) {
+        aging_rate = PRIORITY_AGING_RATE;
+        mlfq_quanta.assign({Q1_QUANTUM, Q2_QUANTUM});
+        promotion_threshold = Q3_PROMOTION_THRESHOLD;
+        mlq_q2_quantum = MLQ_Q2_QUANTUM;
+        switch_cost = resume_penalty = 0;
+        if (!config) return;
+        if (config->aging_rate > 0) aging_rate = config->aging_rate;
+        if (config->promotion_threshold > 0) promotion_threshold = config->promotion_threshold;
+        if (config->mlq_q2_quantum > 0) mlq_q2_quantum = config->mlq_q2_quantum;
+        if (config->switch_cost > 0) switch_cost = config->switch_cost;
+        if (config->resume_penalty > 0) resume_penalty = config->resume_penalty;
+        if (config->mlfq_levels > 0) {
+            mlfq_quanta.resize(config->mlfq_levels - 1);
+            long long quantum = Q1_QUANTUM;
+            for (int level = 0; level < config->mlfq_levels - 1; level++) {
+                int q = config->mlfq_quanta ? config->mlfq_quanta[level] : (int)std::min<long long>(INT_MAX, quantum);
+                mlfq_quanta[level] = std::max(1, q);
+                quantum *= 2;
+            }
         }
-        procs[i].last_q3_entry = -1;
-        queue.push_back(procs[i]);
     }
 
-    std::vector<GanttLog> local_logs;
-    int current_time = 0;
-    int completed = 0;
-    
-    // 0: FCFS, 1: SJF, 2: SRTF, 3: Prio-NP, 4: Prio-P, 5: RR, 6: MLFQ, 7: MLQ
-    
-    // --- MLQ LOGIC (Code 7) ---
-    if (algorithm_code == 7) {
-        // Ready queues grouped by fixed assignment (1, 2, 3)
-        std::map<int, std::vector<int>> ready_queues; 
-        std::vector<bool> in_ready_queue(n, false);
-        
-        auto check_arrivals = [&](int t) {
-            for(int i=0; i<n; i++) {
-                if(!in_ready_queue[i] && queue[i].rem_time > 0 && queue[i].at <= t) {
-                    int target_q = queue[i].current_queue; 
-                    ready_queues[target_q].push_back(i);
-                    in_ready_queue[i] = true;
-                    
-                    // Q1 (Priority P): Sort by base_priority (lower=higher) then AT
-                    if (target_q == 1) {
-                        std::sort(ready_queues[1].begin(), ready_queues[1].end(), [&](int a, int b) {
-                            if (queue[a].base_priority != queue[b].base_priority) {
-                                return queue[a].base_priority < queue[b].base_priority;
-                            }
-                            return queue[a].at < queue[b].at;
-                        });
-                    } 
-                    // Q3 (FCFS): Sort by AT
-                    else if (target_q == 3) {
-                         std::sort(ready_queues[3].begin(), ready_queues[3].end(), [&](int a, int b) {
-                            return queue[a].at < queue[b].at;
-                        });
-                    }
-                }
-            }
-        };
-
-        while(completed < n) {
-            check_arrivals(current_time);
-
-            int idx = -1;
-            int current_q = -1;
-            int run_time = 1;
-
-            // Phase 2: Strict Priority Selection (Q1 > Q2 > Q3)
-            
-            if (!ready_queues[1].empty()) {
-                idx = ready_queues[1][0]; // Highest priority process
-                current_q = 1;
-            } 
-            else if (!ready_queues[2].empty()) {
-                idx = ready_queues[2].front();
-                ready_queues[2].erase(ready_queues[2].begin()); // Dequeue RR
-                current_q = 2;
-            } 
-            else if (!ready_queues[3].empty()) {
-                idx = ready_queues[3].front();
-                ready_queues[3].erase(ready_queues[3].begin()); // Dequeue FCFS
-                current_q = 3;
-            }
+    bool has_overhead() const { return switch_cost > 0 || resume_penalty > 0; }
+};
 
-            if (idx == -1) {
-                // Handle Idle
-                if(!local_logs.empty() && local_logs.back().pid == -1) local_logs.back().finish++;
-                else local_logs.push_back({-1, current_time, current_time + 1});
-                current_time++;
-                continue;
-            }
+// --- Instrumentation ---
+// Built with -DSCHEDULER_INSTRUMENT, run_scheduler_profiled times the engine's hot paths
+// and counts its events. Without it the probes below compile to nothing; with it every
+// probe costs one thread_local check unless a profiled run is active on the thread.
+#define SCHED_PHASE_SORT 0     // Arrival sort
+#define SCHED_PHASE_ARRIVALS 1 // Arrival scans and admission into the policy
+#define SCHED_PHASE_SELECT 2   // Policy selection, including the aging steps it applies
+#define SCHED_PHASE_PREEMPT 3  // Slice length: the preemption horizon checks
+#define SCHED_PHASE_AGING 4    // Priority aging; nested in SELECT or ARRIVALS
+#define SCHED_PHASE_LOG 5      // Gantt segment merging
+#define SCHED_PHASE_RESULTS 6  // Final copy into the caller's Process array
+#define SCHED_PHASE_COUNT 7
 
-            int selected_pid = queue[idx].pid;
-            
-            // Phase 3: Execution Duration
-            if (current_q == 1) { // Q1: Priority Preemptive (Execute 1 tick)
-                run_time = 1;
-            } else if (current_q == 2) { // Q2: Round Robin (Q=10)
-                run_time = std::min(queue[idx].rem_time, MLQ_Q2_QUANTUM);
-            } else { // Q3: FCFS (Run until completion)
-                run_time = queue[idx].rem_time;
-            }
-            
-            // --- MLQ Master Preemption Check (Q1 arrivals preempt Q2/Q3) ---
-            int next_switch_time = current_time + run_time;
-
-            // Check for arrivals of any Q1 processes during Q2/Q3 execution
-            for (int i=0; i<n; ++i) {
-                if (queue[i].rem_time > 0 && queue[i].current_queue == 1 && queue[i].at > current_time && queue[i].at < next_switch_time) {
-                    next_switch_time = queue[i].at;
-                }
-            }
-            run_time = next_switch_time - current_time;
-            
-            // Sanity check/Re-enqueue if run time was reduced to zero by an arrival
-            if (run_time <= 0) {
-                 if (current_q == 2) ready_queues[2].insert(ready_queues[2].begin(), idx);
-                 else if (current_q == 3) ready_queues[3].insert(ready_queues[3].begin(), idx);
-                 // Q1 index stays in ready_queues[1], no insert needed
-                 current_time++;
-                 continue;
-            }
-            
-            int start = current_time;
-            
-            // Response Time Check
-            if (queue[idx].first_run == -1) {
-                queue[idx].first_run = start;
-                procs[idx].first_run = start; 
-            }
-            
-            current_time += run_time;
-            queue[idx].rem_time -= run_time;
+#define SCHED_CLOCK_NS 0  // Ticks are steady_clock nanoseconds
+#define SCHED_CLOCK_TSC 1 // Ticks are time-stamp counter cycles
 
-            // Log
-            if(!local_logs.empty() && local_logs.back().pid == selected_pid && local_logs.back().finish == start) {
-                local_logs.back().finish = current_time;
-            } else {
-                local_logs.push_back({selected_pid, start, current_time});
-            }
-            
-            // Phase 4: Post-Execution Status Update
-            if(queue[idx].rem_time == 0) {
-                completed++;
-                procs[idx].ct = current_time;
-                procs[idx].tat = procs[idx].ct - procs[idx].at;
-                procs[idx].bt = queue[idx].bt;
-                procs[idx].wt = procs[idx].tat - procs[idx].bt;
-                in_ready_queue[idx] = false; 
-            } else {
-                // Re-enqueue (Preemption or Quantum expiration)
-                if (current_q == 2) {
-                    ready_queues[2].push_back(idx); // RR
-                } 
-                // Q1 runs indefinitely until completion or higher priority/arrival. 
-                // Since Q1 processes are not dequeued until completion, no re-enqueue needed here.
-            }
+// Filled by run_scheduler_profiled. A phase's ticks include the phases nested in it.
+struct SchedulerProfile {
+    int enabled;               // 0 when built without SCHEDULER_INSTRUMENT; all else is then 0
+    int clock;                 // SCHED_CLOCK_*
+    double tick_ns;            // Nanoseconds per tick, calibrated over the run
+    unsigned long long total_ticks;
+    unsigned long long ticks[SCHED_PHASE_COUNT];
+    unsigned long long calls[SCHED_PHASE_COUNT];
+    long long arrivals;        // Processes admitted into the policy
+    long long dispatches;      // Slices run
+    long long preemptions;     // Slices that ended with work left
+    long long completions;
+    long long idle_gaps;
+    long long aging_steps;     // Priority steps applied to waiting processes
+    long long segments;        // Merged Gantt segments
+    int max_ready;             // High-water mark of arrived, unfinished processes
+    int trace_events;          // Phase events in the trace file
+    int trace_dropped;         // Phase events past SCHED_TRACE_MAX_EVENTS, left out of it
+};
+
+#if defined(SCHEDULER_INSTRUMENT)
+#define SCHED_TRACE_MAX_EVENTS (1 << 20)
+
+static inline uint64_t profile_clock() {
+#if defined(SCHED_PROFILE_TSC)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Collects one profiled run. Only the run on the thread that called start() is recorded.
+class Profiler {
+public:
+    struct Event {
+        int phase;
+        uint64_t start, finish;
+    };
+
+    Profiler(SchedulerProfile& stats, bool trace) : stats_(stats), tracing_(trace) {}
+
+    static Profiler*& active() {
+        static thread_local Profiler* current = nullptr;
+        return current;
+    }
+
+    void start() {
+        stats_.enabled = 1;
+#if defined(SCHED_PROFILE_TSC)
+        stats_.clock = SCHED_CLOCK_TSC;
+#else
+        stats_.clock = SCHED_CLOCK_NS;
+#endif
+        wall_start_ = std::chrono::steady_clock::now();
+        start_ = profile_clock();
+        active() = this;
+    }
+
+    void stop() {
+        finish_ = profile_clock();
+        active() = nullptr;
+        double wall_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wall_start_).count();
+        stats_.total_ticks = finish_ - start_;
+        stats_.tick_ns = stats_.total_ticks > 0 ? wall_ns / (double)stats_.total_ticks : 0.0;
+        if (stats_.clock == SCHED_CLOCK_NS) stats_.tick_ns = 1.0;
+        stats_.trace_events = (int)events_.size();
+    }
+
+    void record(int phase, uint64_t start, uint64_t finish) {
+        stats_.ticks[phase] += finish - start;
+        stats_.calls[phase]++;
+        if (!tracing_) return;
+        if (events_.size() < SCHED_TRACE_MAX_EVENTS) events_.push_back({phase, start, finish});
+        else stats_.trace_dropped++;
+    }
+
+    SchedulerProfile& stats() { return stats_; }
+    const SchedulerProfile& stats() const { return stats_; }
+    const std::vector<Event>& events() const { return events_; }
+    uint64_t start_tick() const { return start_; }
+    uint64_t finish_tick() const { return finish_; }
+
+private:
+    SchedulerProfile& stats_;
+    bool tracing_;
+    std::vector<Event> events_;
+    std::chrono::steady_clock::time_point wall_start_;
+    uint64_t start_ = 0;
+    uint64_t finish_ = 0;
+};
+
+// Charges the enclosing scope to a phase of the active profiled run, if any.
+class PhaseTimer {
+public:
+    explicit PhaseTimer(int phase)
+        : profiler_(Profiler::active()), phase_(phase), start_(profiler_ ? profile_clock() : 0) {}
+    ~PhaseTimer() {
+        if (profiler_) profiler_->record(phase_, start_, profile_clock());
+    }
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    Profiler* profiler_;
+    int phase_;
+    uint64_t start_;
+};
+
+#define SCHED_PROFILE_PHASE(phase) PhaseTimer sched_phase_timer(phase)
+#define SCHED_PROFILED(phase, expr) ([&] { SCHED_PROFILE_PHASE(phase); return (expr); }())
+#define SCHED_PROFILE_COUNT(field, amount) \
+    do { if (Profiler* p_ = Profiler::active()) p_->stats().field += (amount); } while (0)
+#define SCHED_PROFILE_HIGH_WATER(field, value) \
+    do { if (Profiler* p_ = Profiler::active()) p_->stats().field = std::max(p_->stats().field, (value)); } while (0)
+#else
+#define SCHED_PROFILE_PHASE(phase) ((void)0)
+#define SCHED_PROFILED(phase, expr) (expr)
+#define SCHED_PROFILE_COUNT(field, amount) ((void)0)
+#define SCHED_PROFILE_HIGH_WATER(field, value) ((void)0)
+#endif
+
+// --- Gantt output ---
+// Receives each full chunk of merged segments from run_scheduler_stream. The chunk
+// buffer is reused as soon as the callback returns.
+typedef void (*GanttSink)(const GanttLog* segments, int count, void* user);
+
+// Merges consecutive segments of the same pid (or Idle) and writes them into a bounded
+// chunk buffer. With a sink the chunk is handed over and reused whenever it fills up, so
+// memory stays constant however long the timeline gets; without one, segments past the
+// buffer capacity are counted but not stored.
+class GanttWriter {
+public:
+    GanttWriter(GanttLog* chunk, int capacity, GanttSink sink, void* user)
+        : chunk_(chunk), capacity_(capacity), sink_(sink), user_(user) {}
+
+    void add(int pid, int start, int finish) {
+        SCHED_PROFILE_PHASE(SCHED_PHASE_LOG);
+        if (pid == GANTT_PID_IDLE) idle_time_ += finish - start;
+        else if (pid == GANTT_PID_SWITCH) switch_time_ += finish - start;
+        else if (pid < GANTT_PID_SWITCH) warmup_time_ += finish - start;
+        if (has_open_ && open_.pid == pid && open_.finish == start) {
+            open_.finish = finish;
+            return;
         }
+        if (has_open_) emit(open_);
+        open_ = {pid, start, finish};
+        has_open_ = true;
     }
-    // --- MLFQ LOGIC (Code 6) ---
-    else if (algorithm_code == 6) {
-        std::vector<int> q1_ready; // RR (Q=8)
-        std::vector<int> q2_ready; // RR (Q=16)
-        std::vector<int> q3_ready; // FCFS (Wait list)
-        
-        std::vector<bool> in_ready_queue(n, false);
-        
-        auto check_arrivals = [&](int t) {
-            for(int i=0; i<n; i++) {
-                if(!in_ready_queue[i] && queue[i].rem_time > 0 && queue[i].at <= t) {
-                    q1_ready.push_back(i); // All new arrivals go to Q1
-                    in_ready_queue[i] = true;
-                }
-            }
-        };
-
-        while(completed < n) {
-            check_arrivals(current_time);
-
-            // Phase 1: Q3 Promotion (Aging)
-            for(size_t i = 0; i < q3_ready.size(); ) {
-                int idx = q3_ready[i];
-                if (queue[idx].last_q3_entry != -1 && (current_time - queue[idx].last_q3_entry) >= Q3_PROMOTION_THRESHOLD) {
-                    queue[idx].current_queue = 2;
-                    queue[idx].last_q3_entry = -1;
-                    q2_ready.push_back(idx);
-                    q3_ready.erase(q3_ready.begin() + i);
-                } else {
-                    ++i;
-                }
-            }
 
-            int idx = -1;
-            int current_q = -1;
-            int current_quantum = 0;
-
-            // Phase 2: Selection (Priority Q1 > Q2 > Q3)
-            if (!q1_ready.empty()) {
-                idx = q1_ready.front();
-                q1_ready.erase(q1_ready.begin());
-                current_q = 1;
-                current_quantum = Q1_QUANTUM;
-            } else if (!q2_ready.empty()) {
-                idx = q2_ready.front();
-                q2_ready.erase(q2_ready.begin());
-                current_q = 2;
-                current_quantum = Q2_QUANTUM;
-            } else if (!q3_ready.empty()) {
-                idx = q3_ready.front();
-                q3_ready.erase(q3_ready.begin());
-                current_q = 3;
-                current_quantum = queue[idx].rem_time; 
-            }
+    // Emits the trailing segment and delivers whatever is still buffered.
+    void finish() {
+        if (has_open_) emit(open_);
+        has_open_ = false;
+        flush();
+    }
 
-            if (idx == -1) {
-                if(!local_logs.empty() && local_logs.back().pid == -1) local_logs.back().finish++;
-                else local_logs.push_back({-1, current_time, current_time + 1});
-                current_time++;
-                continue;
-            }
+    // Hands the buffered segments to the sink; the open segment stays open for merging.
+    void flush() {
+        if (sink_ && stored_ > 0) sink_(chunk_, stored_, user_);
+        if (sink_) stored_ = 0;
+    }
 
-            // Phase 3: Execution
-            int exec_time = (queue[idx].rem_time < current_quantum) ? queue[idx].rem_time : current_quantum;
-            int start = current_time;
-            
-            if (queue[idx].first_run == -1) {
-                queue[idx].first_run = start;
-                procs[idx].first_run = start; 
-            }
-            
-            current_time += exec_time;
-            queue[idx].rem_time -= exec_time;
+    int total() const { return total_; }   // Merged segments produced so far
+    int stored() const { return stored_; } // Segments currently held in the chunk buffer
+    int idle_segments() const { return idle_segments_; }
+    int idle_time() const { return idle_time_; }
+    int overhead_segments() const { return overhead_segments_; }
+    int switch_time() const { return switch_time_; }
+    int warmup_time() const { return warmup_time_; }
+    // Process segments beyond one per process, i.e. how often a process got the CPU back
+    int context_switches(int n) const { return std::max(0, total_ - idle_segments_ - overhead_segments_ - n); }
 
-            // Log
-            if(!local_logs.empty() && local_logs.back().pid == queue[idx].pid && local_logs.back().finish == start) {
-                local_logs.back().finish = current_time;
-            } else {
-                local_logs.push_back({queue[idx].pid, start, current_time});
-            }
-            
-            check_arrivals(current_time);
-
-            // Phase 4: Post-Execution Status Update (Demotion/Completion)
-            if(queue[idx].rem_time == 0) {
-                completed++;
-                procs[idx].ct = current_time;
-                procs[idx].tat = procs[idx].ct - procs[idx].at;
-                procs[idx].bt = queue[idx].bt;
-                procs[idx].wt = procs[idx].tat - procs[idx].bt;
-                in_ready_queue[idx] = false;
-            } else {
-                if (exec_time < current_quantum && current_q != 3) {
-                    // Finished segment early (re-enqueue in same queue, unless Q3)
-                    if (current_q == 1) q1_ready.push_back(idx);
-                    else if (current_q == 2) q2_ready.push_back(idx);
-                } else if (current_q != 3) {
-                    // Quantum expired -> Demote (Q3 is handled by FCFS completion rule)
-                    queue[idx].current_queue++;
-                    
-                    if (queue[idx].current_queue == 2) {
-                        q2_ready.push_back(idx);
-                    } else if (queue[idx].current_queue >= 3) {
-                        queue[idx].current_queue = 3;
-                        q3_ready.push_back(idx);
-                        queue[idx].last_q3_entry = current_time;
-                    }
-                }
-                in_ready_queue[idx] = true;
-            }
-            procs[idx].current_queue = queue[idx].current_queue; 
-        }
-    }
-    // --- GENERIC LOGIC (Codes 0, 1, 2, 3, 4, 5) ---
-    else {
-        // --- RR LOGIC (Code 5) ---
-        if (algorithm_code == 5) {
-            std::vector<int> ready_queue;
-            std::vector<bool> in_queue(n, false);
-
-            while(completed < n) {
-                for(int i=0; i<n; i++) {
-                    if(!in_queue[i] && queue[i].rem_time > 0 && queue[i].at <= current_time) {
-                        ready_queue.push_back(i);
-                        in_queue[i] = true;
-                    }
-                }
-
-                if(ready_queue.empty()) {
-                    if(!local_logs.empty() && local_logs.back().pid == -1) local_logs.back().finish++;
-                    else local_logs.push_back({-1, current_time, current_time + 1});
-                    current_time++;
-                    continue;
-                }
-
-                int idx = ready_queue.front();
-                ready_queue.erase(ready_queue.begin());
-
-                int exec_time = (queue[idx].rem_time < quantum) ? queue[idx].rem_time : quantum;
-                int start = current_time;
-                
-                if (queue[idx].first_run == -1) {
-                    queue[idx].first_run = start;
-                    procs[idx].first_run = start; 
-                }
-                
-                int next_arrival_time = -1;
-                for(int i=0; i<n; ++i) {
-                    if (!in_queue[i] && queue[i].rem_time > 0) {
-                        if (next_arrival_time == -1 || queue[i].at < next_arrival_time) {
-                            next_arrival_time = queue[i].at;
-                        }
-                    }
-                }
-                
-                if (next_arrival_time != -1 && start + exec_time > next_arrival_time) {
-                    exec_time = next_arrival_time - start;
-                    if (exec_time <= 0) {
-                        current_time = next_arrival_time;
-                        ready_queue.insert(ready_queue.begin(), idx);
-                        continue;
-                    }
-                }
-
-                current_time += exec_time;
-                queue[idx].rem_time -= exec_time;
-
-                if(!local_logs.empty() && local_logs.back().pid == queue[idx].pid && local_logs.back().finish == start) {
-                    local_logs.back().finish = current_time;
-                } else {
-                    local_logs.push_back({queue[idx].pid, start, current_time});
-                }
-
-                for(int i=0; i<n; i++) {
-                    if(!in_queue[i] && queue[i].rem_time > 0 && queue[i].at <= current_time) {
-                        ready_queue.push_back(i);
-                        in_queue[i] = true;
-                    }
-                }
-
-                if(queue[idx].rem_time > 0) {
-                    ready_queue.push_back(idx);
-                } else {
-                    completed++;
-                    procs[idx].ct = current_time;
-                    procs[idx].tat = procs[idx].ct - procs[idx].at;
-                    procs[idx].bt = queue[idx].bt;
-                    procs[idx].wt = procs[idx].tat - procs[idx].bt;
-                    in_queue[idx] = false;
-                }
-            }
+private:
+    void emit(const GanttLog& seg) {
+        total_++;
+        if (seg.pid == GANTT_PID_IDLE) idle_segments_++;
+        else if (seg.pid < GANTT_PID_IDLE) overhead_segments_++;
+        if (stored_ == capacity_) {
+            if (!sink_) return;
+            sink_(chunk_, stored_, user_);
+            stored_ = 0;
         }
-        
-        // --- GENERIC LOGIC (Codes 0, 1, 2, 3, 4) ---
-        else {
-            while(completed < n) {
-                int idx = -1;
-                
-                // Phase 1: Aging 
-                if (algorithm_code == 3 || algorithm_code == 4) {
-                    for (int i=0; i<n; ++i) {
-                        if (queue[i].rem_time > 0 && queue[i].at <= current_time && queue[i].first_run == -1) {
-                            int wait_time = current_time - queue[i].at;
-                            int boost = wait_time / PRIORITY_AGING_RATE; 
-                            queue[i].current_priority = std::max(1, queue[i].base_priority - boost);
-                            procs[i].current_priority = queue[i].current_priority;
-                        }
-                    }
-                }
-
-                // Find candidates
-                std::vector<int> candidates;
-                for(int i=0; i<n; i++) {
-                    if(queue[i].at <= current_time && queue[i].rem_time > 0) {
-                        candidates.push_back(i);
-                    }
-                }
-
-                if(candidates.empty()) {
-                     if(!local_logs.empty() && local_logs.back().pid == -1) local_logs.back().finish++;
-                     else local_logs.push_back({-1, current_time, current_time + 1});
-                    current_time++;
-                    continue;
-                }
-
-                // --- SELECTION LOGIC ---
-                idx = candidates[0];
-                for(int i : candidates) {
-                    if (algorithm_code == 0) { // FCFS
-                        if (queue[i].at < queue[idx].at) idx = i;
-                    }
-                    else if (algorithm_code == 1 || algorithm_code == 2) { // SJF/SRTF
-                        if (queue[i].rem_time < queue[idx].rem_time || 
-                            (queue[i].rem_time == queue[idx].rem_time && queue[i].at < queue[idx].at)) {
-                            idx = i;
-                        }
-                    }
-                    else if (algorithm_code == 3 || algorithm_code == 4) { // Priority
-                        if (queue[i].current_priority < queue[idx].current_priority ||
-                            (queue[i].current_priority == queue[idx].current_priority && queue[i].at < queue[idx].at)) {
-                            idx = i;
-                        }
-                    }
-                }
-
-                // --- EXECUTION DURATION CALCULATION ---
-                int run_time = 1;
-                int selected_pid = queue[idx].pid;
-
-                if(algorithm_code == 0 || algorithm_code == 1 || algorithm_code == 3) {
-                    run_time = queue[idx].rem_time;
-                } 
-                else {
-                    int next_switch_time = current_time + queue[idx].rem_time;
-
-                    for (int i=0; i<n; ++i) {
-                        if (i == idx || queue[i].rem_time == 0) continue;
-                        
-                        if (queue[i].at > current_time && queue[i].at < next_switch_time) {
-                            bool arrival_preempts = false;
-                            if (algorithm_code == 2) { 
-                                if (queue[i].rem_time < queue[idx].rem_time) arrival_preempts = true;
-                            } else if (algorithm_code == 4) { 
-                                if (queue[i].current_priority < queue[idx].current_priority) arrival_preempts = true;
-                            }
-
-                            if (arrival_preempts) {
-                                next_switch_time = queue[i].at;
-                            }
-                        }
-                        
-                        if (algorithm_code == 4 && queue[i].at <= current_time) {
-                            if (queue[i].current_priority < queue[idx].current_priority) {
-                                run_time = 1;
-                            }
-                        }
-                    }
-                    run_time = std::min(run_time, next_switch_time - current_time);
-                }
-
-                if (run_time <= 0) { 
-                    current_time++; 
-                    continue; 
-                }
-
-                int start = current_time;
-                
-                if (queue[idx].first_run == -1) {
-                    queue[idx].first_run = start;
-                    procs[idx].first_run = start; 
-                }
-
-                current_time += run_time;
-                queue[idx].rem_time -= run_time;
-
-                 if(!local_logs.empty() && local_logs.back().pid == selected_pid && local_logs.back().finish == start) {
-                    local_logs.back().finish = current_time;
-                } else {
-                    local_logs.push_back({selected_pid, start, current_time});
-                }
-
-                if(queue[idx].rem_time == 0) {
-                    completed++;
-                    procs[idx].ct = current_time;
-                    procs[idx].tat = procs[idx].ct - procs[idx].at;
-                    procs[idx].bt = queue[idx].bt;
-                    procs[idx].wt = procs[idx].tat - procs[idx].bt;
-                }
-            }
+        chunk_[stored_++] = seg;
+    }
+
+    GanttLog* chunk_;
+    int capacity_;
+    GanttSink sink_;
+    void* user_;
+    GanttLog open_ = {0, 0, 0}; // Last segment, still open for merging
+    bool has_open_ = false;
+    int stored_ = 0;
+    int total_ = 0;
+    int idle_segments_ = 0;
+    int idle_time_ = 0;
+    int overhead_segments_ = 0;
+    int switch_time_ = 0;
+    int warmup_time_ = 0;
+};
+
+// --- Simulation state ---
+// Read-only view of the caller's processes. Only pid/at/bt/priority are read and nothing
+// is written back, so one input can be simulated any number of times without a reset.
+// Binary traces leave procs NULL and supply the at/bt/priority columns instead; their
+// pids are the 1-based positions.
+struct InputView {
+    const Process* procs;
+    int n;
+    const int* mlq_queues; // MLQ queue id per process, or NULL to take it from priority
+    const int* at_column = nullptr;
+    const int* bt_column = nullptr;
+    const int* priority_column = nullptr;
+    const IoPlan* io = nullptr; // Burst sequences (run_scheduler_io only), or NULL
+
+    int pid(int i) const { return procs ? procs[i].pid : i + 1; }
+    int at(int i) const { return procs ? procs[i].at : at_column[i]; }
+    // The first CPU burst: the one the process arrives with
+    int bt(int i) const {
+        if (has_plan(i)) return io->bursts[io->offsets[i]];
+        return procs ? procs[i].bt : bt_column[i];
+    }
+    bool has_plan(int i) const { return io && io->offsets[i + 1] > io->offsets[i]; }
+
+    // Calls f(burst) for each CPU burst of process i, then returns its total I/O time.
+    template <typename F>
+    long long for_each_cpu_burst(int i, F f) const {
+        if (!has_plan(i)) {
+            f(bt(i));
+            return 0;
+        }
+        long long io_time = 0;
+        for (int k = io->offsets[i]; k < io->offsets[i + 1]; k++) {
+            if ((k - io->offsets[i]) % 2 == 0) f(io->bursts[k]);
+            else io_time += io->bursts[k];
+        }
+        return io_time;
+    }
+
+    // Priority the run is keyed on: for MLQ this is the assigned queue id.
+    int priority(int i, int algorithm_code) const {
+        if (algorithm_code == 7 && mlq_queues) return mlq_queues[i];
+        return procs ? procs[i].priority : priority_column[i];
+    }
+};
+
+// Scratch memory for the policies' queues. Blocks are handed out in the same order on
+// every run and keep their capacity when the arena is rewound, so once a run shape has
+// been seen, repeating it allocates nothing. Block pointers stay valid until the next
+// rewind (moving a std::vector keeps its buffer).
+class ScratchArena {
+public:
+    void rewind() { next_ = 0; }
+    void release() { blocks_.clear(); blocks_.shrink_to_fit(); next_ = 0; }
+
+    // count ints, all set to value
+    int* take(size_t count, int value) {
+        if (next_ == blocks_.size()) blocks_.emplace_back();
+        std::vector<int>& block = blocks_[next_++];
+        block.assign(std::max<size_t>(1, count), value);
+        return block.data();
+    }
+
+private:
+    std::vector<std::vector<int>> blocks_;
+    size_t next_ = 0;
+};
+
+// Mutable per-run state, one array per field (indexed like the input) so the hot loops
+// only pull in the columns they read. The vectors keep their capacity across resets,
+// which lets a batch worker reuse one state for all of its jobs.
+struct SimState {
+    std::vector<int> at;            // Arrival time (copied for locality); with I/O, when the process last became ready
+    std::vector<int> rem;           // Remaining burst
+    std::vector<int> base_prio;     // Priority before aging (MLQ: queue id)
+    std::vector<int> prio;          // Aged priority
+    std::vector<int> queue_id;      // MLFQ/MLQ queue (1-3), -1 for the other algorithms
+    std::vector<int> first_run;     // Start of the first slice, -1 before it runs
+    std::vector<int> ct;            // Completion time
+    std::vector<int> last_q3_entry; // MLFQ: time the process entered Q3
+    std::vector<int> aging_due;     // Prio-NP/P: next time a waiting process's aged priority drops
+    std::vector<int> io_time;       // I/O runs only: time blocked on devices, queueing included
+
+    // Pending-arrival columns in arrival order (position k = arrival_order[k]), scanned for
+    // the preemption horizon: arr_key is at + bt for SRTF, the priority for Prio-P and the
+    // queue id for MLQ. None of these change before a process arrives.
+    std::vector<int> arr_at;
+    std::vector<int> arr_key;
+
+    std::vector<int> batch; // Processes admitted by the latest take_arrivals call
+    ScratchArena scratch;   // Policy queues, rewound on every reset
+
+    void reset(const InputView& input, int algorithm_code) {
+        int n = std::max(0, input.n);
+        scratch.rewind();
+        resize(n);
+        for (int i = 0; i < n; i++) init_process(i, input.at(i), input.bt(i), input.priority(i, algorithm_code), algorithm_code);
+        io_time.assign(input.io ? n : 0, 0);
+    }
+
+    // Sizes the per-process columns for n processes (their contents are set by init_process).
+    void resize(int n) {
+        at.resize(n);
+        rem.resize(n);
+        base_prio.resize(n);
+        prio.resize(n);
+        queue_id.resize(n);
+        first_run.resize(n);
+        ct.resize(n);
+        last_q3_entry.resize(n);
+        aging_due.resize(n);
+    }
+
+    void init_process(int i, int arrival, int burst, int priority, int algorithm_code) {
+        at[i] = arrival;
+        rem[i] = std::max(0, burst);
+        base_prio[i] = prio[i] = priority;
+        if (algorithm_code == 6) queue_id[i] = 1; // MLFQ: Start in Q1
+        else if (algorithm_code == 7) queue_id[i] = std::min(3, std::max(1, priority));
+        else queue_id[i] = -1;
+        first_run[i] = -1;
+        ct[i] = 0;
+        last_q3_entry[i] = -1;
+    }
+};
+
+// Whether the policy scans the pending-arrival columns for its preemption horizon.
+static bool uses_horizon_columns(int algorithm_code) {
+    return algorithm_code == 2 || algorithm_code == 4 || algorithm_code == 7;
+}
+
+static int horizon_key(const SimState& st, int i, int algorithm_code) {
+    if (algorithm_code == 2) return st.at[i] + st.rem[i];
+    if (algorithm_code == 4) return st.base_prio[i];
+    return st.queue_id[i];
+}
+
+static void build_horizon_columns(SimState& st, const std::vector<int>& arrival_order, int algorithm_code) {
+    st.arr_at.resize(arrival_order.size());
+    st.arr_key.resize(arrival_order.size());
+    for (size_t k = 0; k < arrival_order.size(); k++) {
+        int i = arrival_order[k];
+        st.arr_at[k] = st.at[i];
+        st.arr_key[k] = horizon_key(st, i, algorithm_code);
+    }
+}
+
+// Writes the finished run into out (n entries, may alias the input) in the layout the
+// Python side reads: inputs echoed back, rem_time left at the burst, base_priority = priority.
+static void write_results(const InputView& input, const SimState& st, Process* out) {
+    SCHED_PROFILE_PHASE(SCHED_PHASE_RESULTS);
+    for (int i = 0; i < input.n; i++) {
+        Process p;
+        p.pid = input.pid(i);
+        p.at = input.at(i);
+        p.bt = input.bt(i);
+        if (input.io) {
+            // Total CPU time; waiting excludes the time blocked on I/O
+            p.bt = 0;
+            input.for_each_cpu_burst(i, [&](int burst) { p.bt += burst; });
+        }
+        p.priority = p.base_priority = st.base_prio[i];
+        p.current_priority = st.prio[i];
+        p.rem_time = p.bt;
+        p.first_run = st.first_run[i];
+        p.ct = st.ct[i];
+        p.tat = p.ct - p.at;
+        p.wt = p.tat - std::max(0, p.bt) - (input.io ? st.io_time[i] : 0);
+        p.current_queue = st.queue_id[i];
+        p.last_q3_entry = -1;
+        out[i] = p;
+    }
+}
+
+// --- I/O bursts ---
+// A process leaving the CPU for I/O is queued on its device and comes back as a new
+// arrival once the I/O completes. Devices serve FCFS and the engine blocks processes in
+// time order, so the completion time is known when the process blocks: it goes straight
+// into a wake-up heap that the arrival cursor drains alongside the arrival order, and
+// nothing is polled per tick.
+class IoEvents {
+public:
+    void reset(const InputView& input, SimState& st) {
+        plan_ = input.io;
+        st_ = &st;
+        next_.assign(std::max(0, input.n), 0);
+        for (int i = 0; i < input.n; i++) next_[i] = input.has_plan(i) ? plan_->offsets[i] + 1 : 0;
+        device_free_.assign(std::max(1, plan_->num_devices), INT_MIN);
+        wakes_.clear();
+    }
+
+    // Sends idx, whose CPU burst ended at t, to its next I/O burst and sets up the CPU
+    // burst after it. Returns false if that was its last CPU burst.
+    bool block(int idx, int t) {
+        int k = next_[idx];
+        if (k == 0 || k >= plan_->offsets[idx + 1]) return false;
+        int device = plan_->devices ? plan_->devices[k] : 0;
+        int wake = std::max(t, device_free_[device]) + plan_->bursts[k];
+        device_free_[device] = wake;
+        st_->io_time[idx] += wake - t;
+        st_->rem[idx] = plan_->bursts[k + 1];
+        st_->at[idx] = wake; // Ready again from the wake-up, for FCFS ordering
+        next_[idx] = k + 2;
+        wakes_.push_back({wake, idx});
+        std::push_heap(wakes_.begin(), wakes_.end(), std::greater<std::pair<int, int>>());
+        return true;
+    }
+
+    int next_wake() const { return wakes_.empty() ? INT_MAX : wakes_.front().first; }
+
+    // Appends the processes whose I/O completed by t, in (wake-up, index) order.
+    void take(int t, std::vector<int>& batch) {
+        while (!wakes_.empty() && wakes_.front().first <= t) {
+            batch.push_back(wakes_.front().second);
+            std::pop_heap(wakes_.begin(), wakes_.end(), std::greater<std::pair<int, int>>());
+            wakes_.pop_back();
+        }
+    }
+
+private:
+    const IoPlan* plan_ = nullptr;
+    SimState* st_ = nullptr;
+    std::vector<int> next_;        // Position of each process's next I/O burst; 0 without a plan
+    std::vector<int> device_free_; // When each device finishes the requests queued on it
+    std::vector<std::pair<int, int>> wakes_; // (wake-up, process) min-heap
+};
+
+// --- Arrival ordering ---
+// Processes are sorted by (at, input index) once per run; admission then just advances
+// a cursor instead of rescanning all n processes on every iteration.
+// The order only depends on at/bt, so a batch builds it once and shares it across jobs.
+struct ArrivalCursor {
+    explicit ArrivalCursor(const std::vector<int>& arrival_order) : order(arrival_order) {}
+
+    const std::vector<int>& order; // Process indices in arrival order (zero-length bursts excluded)
+    size_t pos = 0;                // First process that has not arrived yet
+    IoEvents* io = nullptr;        // I/O wake-ups, admitted like arrivals (I/O runs only)
+};
+
+static void build_arrival_order(const InputView& input, bool presorted, std::vector<int>& order) {
+    SCHED_PROFILE_PHASE(SCHED_PHASE_SORT);
+    order.clear();
+    for(int i=0; i<input.n; i++) {
+        if(input.bt(i) > 0) order.push_back(i);
+    }
+    if(!presorted) {
+        std::sort(order.begin(), order.end(), [&](int a, int b) {
+            if (input.at(a) != input.at(b)) return input.at(a) < input.at(b);
+            return a < b;
+        });
+    }
+}
+
+// Earliest arrival or I/O wake-up that has not been admitted yet (INT_MAX if none).
+static int next_arrival_time(const SimState& st, const ArrivalCursor& arrivals) {
+    int next_at = arrivals.pos < arrivals.order.size() ? st.at[arrivals.order[arrivals.pos]] : INT_MAX;
+    return arrivals.io ? std::min(next_at, arrivals.io->next_wake()) : next_at;
+}
+
+// Moves every pending process with at <= t into batch, in (at, index) order. FIFO schedulers
+// pass index_order so that one batch is enqueued in input order, as the full scans used to.
+static void take_arrivals(const SimState& st, ArrivalCursor& arrivals, int t, bool index_order, std::vector<int>& batch) {
+    batch.clear();
+    while(arrivals.pos < arrivals.order.size() && st.at[arrivals.order[arrivals.pos]] <= t) {
+        batch.push_back(arrivals.order[arrivals.pos++]);
+    }
+    if (arrivals.io) {
+        // Wake-ups join in (ready time, index) order too
+        size_t arrived = batch.size();
+        arrivals.io->take(t, batch);
+        if (!index_order && arrived > 0 && arrived < batch.size()) {
+            std::inplace_merge(batch.begin(), batch.begin() + arrived, batch.end(), [&](int a, int b) {
+                return st.at[a] != st.at[b] ? st.at[a] < st.at[b] : a < b;
+            });
+        }
+    }
+    if(index_order && !std::is_sorted(batch.begin(), batch.end())) std::sort(batch.begin(), batch.end());
+}
+
+// --- Preemption horizon scan ---
+// Finds the first pending arrival k in [begin, end) that lands before horizon and whose key
+// passes the gate: key < threshold, or key >= threshold with AtLeast. at must be ascending,
+// so the scan ends at the first block that reaches the horizon. Returns -1 if none qualifies.
+
+static inline int lowest_set_bit(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return (int)bit;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+static inline int highest_set_bit(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanReverse(&bit, mask);
+    return (int)bit;
+#else
+    return 31 - __builtin_clz(mask);
+#endif
+}
+
+template <bool AtLeast>
+static int first_gated_arrival(const int* at, const int* key, int begin, int end, int horizon, int threshold) {
+    int k = begin;
+#if defined(__AVX2__)
+    const __m256i h = _mm256_set1_epi32(horizon);
+    const __m256i th = _mm256_set1_epi32(threshold);
+    for (; k + 8 <= end; k += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(at + k));
+        __m256i kv = _mm256_loadu_si256((const __m256i*)(key + k));
+        __m256i before = _mm256_cmpgt_epi32(h, a);
+        __m256i below = _mm256_cmpgt_epi32(th, kv);
+        __m256i hit = AtLeast ? _mm256_andnot_si256(below, before) : _mm256_and_si256(below, before);
+        unsigned hits = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(hit));
+        if (hits) return k + lowest_set_bit(hits);
+        if ((unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(before)) != 0xFFu) return -1;
+    }
+#elif defined(SCHED_USE_NEON)
+    const int32x4_t h = vdupq_n_s32(horizon);
+    const int32x4_t th = vdupq_n_s32(threshold);
+    static const uint32_t lane_bits[4] = {1, 2, 4, 8};
+    const uint32x4_t bits = vld1q_u32(lane_bits);
+    for (; k + 4 <= end; k += 4) {
+        uint32x4_t before = vcltq_s32(vld1q_s32(at + k), h);
+        uint32x4_t below = vcltq_s32(vld1q_s32(key + k), th);
+        uint32x4_t hit = AtLeast ? vbicq_u32(before, below) : vandq_u32(before, below);
+        unsigned hits = vaddvq_u32(vandq_u32(hit, bits));
+        if (hits) return k + lowest_set_bit(hits);
+        if (vminvq_u32(before) == 0) return -1;
+    }
+#endif
+    for (; k < end; k++) {
+        if (at[k] >= horizon) return -1;
+        if ((key[k] < threshold) != AtLeast) return k;
+    }
+    return -1;
+}
+
+// --- Ready queues ---
+// Indexed binary min-heap of process indices. The position map lets a single entry be
+// re-keyed or removed in O(log n) when its remaining time or aged priority changes.
+template <typename Less>
+class IndexedHeap {
+public:
+    IndexedHeap(ScratchArena& scratch, int n, Less less)
+        : heap_(scratch.take(n, 0)), pos_(scratch.take(n, -1)), n_(n), less_(less) {}
+
+    // Moves the heap into larger storage for n processes (online sessions).
+    void grow(ScratchArena& scratch, int n) {
+        int* heap = scratch.take(n, 0);
+        int* pos = scratch.take(n, -1);
+        std::copy(heap_, heap_ + size_, heap);
+        std::copy(pos_, pos_ + n_, pos);
+        heap_ = heap;
+        pos_ = pos;
+        n_ = n;
+    }
+
+    bool empty() const { return size_ == 0; }
+    int top() const { return heap_[0]; }
+
+    void push(int i) {
+        pos_[i] = size_;
+        heap_[size_++] = i;
+        sift_up(pos_[i]);
+    }
+
+    void remove(int i) {
+        int k = pos_[i];
+        int last = heap_[--size_];
+        pos_[i] = -1;
+        if (last == i) return;
+        heap_[k] = last;
+        pos_[last] = k;
+        // The moved entry may belong either above or below its new slot
+        sift_up(k);
+        sift_down(pos_[last]);
+    }
+
+    bool contains(int i) const { return pos_[i] != -1; }
+
+    // Restores heap order after the key of i decreased
+    void update(int i) { sift_up(pos_[i]); }
+
+private:
+    void place(int k, int i) { heap_[k] = i; pos_[i] = k; }
+
+    void sift_up(int k) {
+        int i = heap_[k];
+        while (k > 0) {
+            int parent = (k - 1) / 2;
+            if (!less_(i, heap_[parent])) break;
+            place(k, heap_[parent]);
+            k = parent;
+        }
+        place(k, i);
+    }
+
+    void sift_down(int k) {
+        int i = heap_[k];
+        while (true) {
+            int child = 2 * k + 1;
+            if (child >= size_) break;
+            if (child + 1 < size_ && less_(heap_[child + 1], heap_[child])) child++;
+            if (!less_(heap_[child], i)) break;
+            place(k, heap_[child]);
+            k = child;
+        }
+        place(k, i);
+    }
+
+    int* heap_;
+    int* pos_; // Heap slot of each process, -1 when absent
+    int size_ = 0;
+    int n_;
+    Less less_;
+};
+
+// Fixed-capacity FIFO over caller-provided storage: O(1) push at either end and pop at the
+// front. A process sits in at most one queue at a time, so n slots per queue always suffice.
+class RingBuffer {
+public:
+    RingBuffer(int* storage, int capacity) : buf_(storage), cap_(capacity) {}
+
+    // Moves the queue, in order, into larger storage.
+    void grow(int* storage, int capacity) {
+        for (int k = 0; k < size_; k++) storage[k] = buf_[wrap(head_ + k)];
+        buf_ = storage;
+        cap_ = capacity;
+        head_ = 0;
+    }
+
+    bool empty() const { return size_ == 0; }
+    int front() const { return buf_[head_]; }
+
+    void push_back(int i) {
+        buf_[wrap(head_ + size_)] = i;
+        size_++;
+    }
+
+    void push_front(int i) {
+        head_ = (head_ == 0) ? cap_ - 1 : head_ - 1;
+        buf_[head_] = i;
+        size_++;
+    }
+
+    int pop_front() {
+        int i = buf_[head_];
+        head_ = wrap(head_ + 1);
+        size_--;
+        return i;
+    }
+
+private:
+    int wrap(int k) const { return k >= cap_ ? k - cap_ : k; }
+
+    int* buf_;
+    int cap_;
+    int head_ = 0;
+    int size_ = 0;
+};
+
+// A set of FIFO levels threaded through one next-pointer array, so any number of
+// levels costs O(n + levels) memory (a process sits in at most one level at a time).
+class FifoLevels {
+public:
+    FifoLevels(ScratchArena& scratch, int n, int levels)
+        : next_(scratch.take(n, -1)), head_(scratch.take(levels, -1)), tail_(scratch.take(levels, -1)), n_(n), levels_(levels) {}
+
+    void grow(ScratchArena& scratch, int n) {
+        int* next = scratch.take(n, -1);
+        std::copy(next_, next_ + n_, next);
+        next_ = next;
+        n_ = n;
+    }
+
+    bool empty(int level) const { return head_[level] == -1; }
+    int front(int level) const { return head_[level]; }
+
+    // Highest (lowest-numbered) level holding a process, or -1 when all are empty
+    int first_non_empty() const {
+        for (int level = 0; level < levels_; level++) {
+            if (head_[level] != -1) return level;
+        }
+        return -1;
+    }
+
+    void push_back(int level, int i) {
+        next_[i] = -1;
+        if (tail_[level] == -1) head_[level] = i;
+        else next_[tail_[level]] = i;
+        tail_[level] = i;
+    }
+
+    int pop_front(int level) {
+        int i = head_[level];
+        head_[level] = next_[i];
+        if (head_[level] == -1) tail_[level] = -1;
+        return i;
+    }
+
+private:
+    int* next_;
+    int* head_;
+    int* tail_;
+    int n_;
+    int levels_;
+};
+
+// Selection order of the generic path: FCFS by AT, SJF/SRTF by remaining time, Priority by
+// aged priority; equal keys fall back to AT and then to the input index.
+template <int Code>
+struct ReadyOrder {
+    const SimState* st;
+
+    bool operator()(int a, int b) const {
+        if (Code == 1 || Code == 2) {
+            if (st->rem[a] != st->rem[b]) return st->rem[a] < st->rem[b];
+        } else if (Code == 3 || Code == 4) {
+            if (st->prio[a] != st->prio[b]) return st->prio[a] < st->prio[b];
         }
+        if (st->at[a] != st->at[b]) return st->at[a] < st->at[b];
+        return a < b;
+    }
+};
+
+// MLQ Q1 order: base priority (lower = higher), then AT, then input index.
+struct MlqPriorityOrder {
+    const SimState* st;
+
+    bool operator()(int a, int b) const {
+        if (st->base_prio[a] != st->base_prio[b]) return st->base_prio[a] < st->base_prio[b];
+        if (st->at[a] != st->at[b]) return st->at[a] < st->at[b];
+        return a < b;
+    }
+};
+
+// Aging timers: waiting processes ordered by their next priority step.
+struct AgingOrder {
+    const SimState* st;
+
+    bool operator()(int a, int b) const {
+        if (st->aging_due[a] != st->aging_due[b]) return st->aging_due[a] < st->aging_due[b];
+        return a < b;
+    }
+};
+
+// Applies the aging rule to a process that has not run yet, and arms its timer for the
+// next step while its priority can still drop.
+static void age_process(SimState& st, IndexedHeap<AgingOrder>& aging, int i, int t, int aging_rate) {
+    SCHED_PROFILE_PHASE(SCHED_PHASE_AGING);
+    int boost = (t - st.at[i]) / aging_rate;
+    st.prio[i] = std::max(1, st.base_prio[i] - boost);
+    if (st.prio[i] > 1) {
+        long long due = st.at[i] + (long long)(boost + 1) * aging_rate;
+        st.aging_due[i] = (int)std::min<long long>(INT_MAX, due);
+        aging.push(i);
+    }
+}
+
+// Idles the CPU until the next arrival.
+static void idle_until_next_arrival(const SimState& st, const ArrivalCursor& arrivals, GanttWriter& writer, int& current_time) {
+    int next_at = next_arrival_time(st, arrivals);
+    writer.add(-1, current_time, next_at);
+    current_time = next_at;
+}
+
+// --- Policy engine ---
+// run_policy() owns the event loop every scheduler shares: admitting arrivals, idling,
+// first-run tracking, running slices into the Gantt writer and completion bookkeeping.
+// Time never advances tick by tick: idle gaps jump straight to the next arrival and
+// every dispatch runs until the next event that can change the selection.
+// A policy only decides who runs next and for how long, through this compile-time
+// interface:
+//   kIndexOrder      admit each arrival batch in input order rather than (at, index) order
+//   kAdmitAfterRun   also admit the arrivals at the end of a slice, before on_preempt
+//   on_arrival(batch, t)    processes that arrived by t
+//   select(t)               process to run at t, or -1 to idle until the next arrival
+//   quantum(idx, t)         length of the slice idx runs from t; always > 0
+//   on_preempt(idx, t, ran) idx stopped at t with work left after running for ran
+//   on_complete(idx, t)     idx finished at t
+//   on_block(idx, t)        idx left the CPU for I/O at t; it comes back through
+//                           on_arrival with its next CPU burst in rem (I/O runs only)
+//   reselect(idx, t)        idx was selected but a switch delayed it to t; the arrivals
+//                           meanwhile are admitted. Returns idx, or the process that
+//                           preempts it (idx re-queued as if preempted)
+//   grow(capacity)          online sessions only: make room for capacity processes
+// A new policy only has to implement these, plus a case in simulate().
+
+// Writes the overhead of handing the CPU from last to idx, when they differ: the context
+// switch, then the cache warm-up if idx is resuming. Both are charged to the CPU, not to
+// idx's burst. Returns the time idx can start.
+static int charge_switch(const SchedParams& params, const SimState& st, GanttWriter& writer, int idx, int& last, int t) {
+    if (idx == last) return t;
+    last = idx;
+    if (params.switch_cost > 0) {
+        writer.add(GANTT_PID_SWITCH, t, t + params.switch_cost);
+        t += params.switch_cost;
+    }
+    if (params.resume_penalty > 0 && st.first_run[idx] != -1) {
+        writer.add(GANTT_PID_WARMUP, t, t + params.resume_penalty);
+        t += params.resume_penalty;
     }
+    return t;
+}
+
+// Hands the processes that arrived by t to the policy.
+template <typename Policy>
+static void admit_arrivals(SimState& st, ArrivalCursor& arrivals, Policy& policy, int t) {
+    SCHED_PROFILE_PHASE(SCHED_PHASE_ARRIVALS);
+    take_arrivals(st, arrivals, t, Policy::kIndexOrder, st.batch);
+    if (!st.batch.empty()) policy.on_arrival(st.batch, t);
+    SCHED_PROFILE_COUNT(arrivals, (long long)st.batch.size());
+}
+
+// Dispatches idx at current_time with the configured switch overhead. The overhead
+// cannot be interrupted; once it is over, the arrivals it overlapped are admitted and
+// the policy may preempt idx in favour of one of them, which then pays its own switch.
+// Returns the process that runs from the updated current_time.
+template <typename Policy>
+static int dispatch_with_overhead(const SchedParams& params, SimState& st, ArrivalCursor& arrivals, GanttWriter& writer,
+                                  Policy& policy, int idx, int& last, int& current_time) {
+    while (idx != last) {
+        int start = charge_switch(params, st, writer, idx, last, current_time);
+        if (start == current_time) break;
+        current_time = start;
+        admit_arrivals(st, arrivals, policy, current_time);
+        idx = policy.reselect(idx, current_time);
+    }
+    return idx;
+}
+
+template <typename Policy>
+static void run_policy(const InputView& input, const SchedParams& params, SimState& st, ArrivalCursor& arrivals,
+                       int completed, GanttWriter& writer, Policy& policy) {
+    int n = std::max(0, input.n);
+    int current_time = 0;
+    int last = -1; // Process whose context the CPU holds
+
+    while(completed < n) {
+        admit_arrivals(st, arrivals, policy, current_time);
+        // Zero-length bursts count as completed but are never admitted
+        SCHED_PROFILE_HIGH_WATER(max_ready, (int)(arrivals.pos + (n - arrivals.order.size())) - completed);
+
+        int idx = SCHED_PROFILED(SCHED_PHASE_SELECT, policy.select(current_time));
+        if (idx == -1) {
+            idle_until_next_arrival(st, arrivals, writer, current_time);
+            SCHED_PROFILE_COUNT(idle_gaps, 1);
+            continue;
+        }
+        if (params.has_overhead()) idx = dispatch_with_overhead(params, st, arrivals, writer, policy, idx, last, current_time);
+
+        int run_time = SCHED_PROFILED(SCHED_PHASE_PREEMPT, policy.quantum(idx, current_time));
+        int start = current_time;
+        SCHED_PROFILE_COUNT(dispatches, 1);
+        
+        // Response Time Check
+        if (st.first_run[idx] == -1) {
+            st.first_run[idx] = start;
+        }
+
+        current_time += run_time;
+        st.rem[idx] -= run_time;
+
+        // Log
+        writer.add(input.pid(idx), start, current_time);
 
-    // Final log copy
-    int count = 0;
-    for(const auto& log : local_logs) {
-        if(count >= max_logs) break;
-        logs[count].pid = log.pid;
-        logs[count].start = log.start;
-        logs[count].finish = log.finish;
-        count++;
+        if (Policy::kAdmitAfterRun) admit_arrivals(st, arrivals, policy, current_time);
+
+        if(st.rem[idx] == 0 && arrivals.io && arrivals.io->block(idx, current_time)) {
+            policy.on_block(idx, current_time);
+        } else if(st.rem[idx] == 0) {
+            completed++;
+            st.ct[idx] = current_time;
+            policy.on_complete(idx, current_time);
+            SCHED_PROFILE_COUNT(completions, 1);
+        } else {
+            policy.on_preempt(idx, current_time, run_time);
+            SCHED_PROFILE_COUNT(preemptions, 1);
+        }
     }
-    return count; 
 }
 
-}
\ No newline at end of file
+// --- Policies ---
+
+// FCFS, SJF, SRTF, Priority NP/P (Codes 0-4): one ready heap ordered by the policy's key.
+// The selected process stays in the heap while it runs.
+template <int Code>
+class ReadyQueuePolicy {
+public:
+    static const bool kIndexOrder = false;
+    static const bool kAdmitAfterRun = false;
+
+    ReadyQueuePolicy(const SchedParams& params, SimState& st, const ArrivalCursor& arrivals)
+        : params_(params), st_(st), arrivals_(arrivals),
+          ready_(st.scratch, (int)st.at.size(), ReadyOrder<Code>{&st}),
+          aging_(st.scratch, kAging ? (int)st.at.size() : 0, AgingOrder{&st}) {}
+
+    void on_arrival(const std::vector<int>& batch, int t) {
+        for (int i : batch) {
+            // Processes back from I/O have run, so they no longer age
+            if (kAging && st_.first_run[i] == -1) age_process(st_, aging_, i, t, params_.aging_rate);
+            ready_.push(i);
+        }
+    }
+
+    int select(int t) {
+        // Phase 1: Aging (only the processes whose step is due are touched)
+        while (kAging && !aging_.empty() && st_.aging_due[aging_.top()] <= t) {
+            int i = aging_.top();
+            aging_.remove(i);
+            age_process(st_, aging_, i, t, params_.aging_rate);
+            ready_.update(i);
+            SCHED_PROFILE_COUNT(aging_steps, 1);
+        }
+        if (ready_.empty()) return -1;
+
+        int idx = ready_.top();
+        // A process stops aging once it gets the CPU
+        if (kAging && aging_.contains(idx)) aging_.remove(idx);
+        return idx;
+    }
+
+    int quantum(int idx, int t) const {
+        if (Code != 2 && Code != 4) return st_.rem[idx]; // Non-preemptive: run to completion
+
+        // Run until the next event that can change the selection: completion,
+        // a preempting arrival, or (Prio-P) the next aging step of a waiting process.
+        int next_switch_time = t + st_.rem[idx];
+
+        if (Code == 4 && !aging_.empty()) {
+            next_switch_time = std::min(next_switch_time, st_.aging_due[aging_.top()]);
+        }
+        // A process back from I/O may preempt; the selection is simply redone then
+        if (arrivals_.io) next_switch_time = std::min(next_switch_time, arrivals_.io->next_wake());
+
+        const int* arr_at = st_.arr_at.data();
+        const int* arr_key = st_.arr_key.data();
+        int begin = (int)arrivals_.pos;
+        int end = (int)arrivals_.order.size();
+        if (Code == 4) {
+            // The first arrival that does not preempt but can still age starts aging
+            // once it arrives; later ones arrive no earlier and step no sooner.
+            int k = first_gated_arrival<true>(arr_at, arr_key, begin, end, next_switch_time, std::max(2, st_.prio[idx]));
+            if (k != -1) next_switch_time = std::min(next_switch_time, arr_at[k] + params_.aging_rate);
+        }
+        // Preempting arrival: SRTF if shorter than what the running process will
+        // have left at that arrival, Prio-P if of higher priority.
+        int threshold = (Code == 2) ? t + st_.rem[idx] : st_.prio[idx];
+        int k = first_gated_arrival<false>(arr_at, arr_key, begin, end, next_switch_time, threshold);
+        if (k != -1) next_switch_time = arr_at[k];
+        return next_switch_time - t;
+    }
+
+    void on_preempt(int idx, int, int) {
+        if (Code == 2) ready_.update(idx); // Remaining time shrank
+    }
+
+    void on_complete(int idx, int) { ready_.remove(idx); }
+    void on_block(int idx, int) { ready_.remove(idx); }
+
+    int reselect(int idx, int t) {
+        if (Code != 2 && Code != 4) return idx; // Non-preemptive: the dispatch stands
+        return select(t); // idx is still queued; this also applies the aging steps due by t
+    }
+
+    void grow(int capacity) {
+        ready_.grow(st_.scratch, capacity);
+        if (kAging) aging_.grow(st_.scratch, capacity);
+    }
+
+private:
+    static const bool kAging = (Code == 3 || Code == 4);
+
+    const SchedParams& params_;
+    SimState& st_;
+    const ArrivalCursor& arrivals_;
+    // Arrived, unfinished processes keyed on the selection order
+    IndexedHeap<ReadyOrder<Code>> ready_;
+    // Waiting processes whose priority can still drop, keyed on their next aging step
+    IndexedHeap<AgingOrder> aging_;
+};
+
+// RR (Code 5): a slice ends on quantum expiry or at the next arrival. Arrivals at the end
+// of a slice queue up ahead of the preempted process.
+class RoundRobinPolicy {
+public:
+    static const bool kIndexOrder = true;
+    static const bool kAdmitAfterRun = true;
+
+    RoundRobinPolicy(int quantum, SimState& st, const ArrivalCursor& arrivals)
+        : quantum_(quantum), st_(st), arrivals_(arrivals),
+          ready_queue_(st.scratch.take(st.at.size(), 0), (int)st.at.size()) {}
+
+    void on_arrival(const std::vector<int>& batch, int) {
+        for (int i : batch) ready_queue_.push_back(i);
+    }
+
+    int select(int) { return ready_queue_.empty() ? -1 : ready_queue_.pop_front(); }
+
+    int quantum(int idx, int t) const {
+        int exec_time = (st_.rem[idx] < quantum_) ? st_.rem[idx] : quantum_;
+        int next_at = next_arrival_time(st_, arrivals_);
+        if (next_at != INT_MAX && t + exec_time > next_at) exec_time = next_at - t;
+        return exec_time;
+    }
+
+    void on_preempt(int idx, int, int) { ready_queue_.push_back(idx); }
+    void on_complete(int, int) {}
+    void on_block(int, int) {}
+    int reselect(int idx, int) { return idx; } // Arrivals never preempt
+    void grow(int capacity) { ready_queue_.grow(st_.scratch.take(capacity, 0), capacity); }
+
+private:
+    int quantum_;
+    SimState& st_;
+    const ArrivalCursor& arrivals_;
+    RingBuffer ready_queue_;
+};
+
+// MLFQ (Code 6): every arrival enters the top level; a process that uses up its quantum
+// drops one level. The last level is FCFS and runs to completion, and a process that has
+// waited promotion_threshold ticks there moves up one level.
+class MlfqPolicy {
+public:
+    static const bool kIndexOrder = true;
+    static const bool kAdmitAfterRun = true;
+
+    MlfqPolicy(const SchedParams& params, SimState& st)
+        : params_(params), st_(st), last_((int)params.mlfq_quanta.size()),
+          levels_(st.scratch, (int)st.at.size(), last_ + 1) {}
+
+    void on_arrival(const std::vector<int>& batch, int t) {
+        for(int i : batch) {
+            // New arrivals go to the top level. A process back from I/O gave up the CPU
+            // before its quantum ran out, so it keeps its level.
+            int level = st_.queue_id[i] - 1;
+            if (level == last_) st_.last_q3_entry[i] = t;
+            levels_.push_back(level, i);
+        }
+    }
+
+    int select(int t) {
+        // Promotion out of the FCFS level (Aging)
+        // Processes join the FCFS level in time order, so the ones due for promotion form a prefix.
+        while (last_ > 0 && !levels_.empty(last_) && (t - st_.last_q3_entry[levels_.front(last_)]) >= params_.promotion_threshold) {
+            int idx = levels_.pop_front(last_);
+            st_.queue_id[idx] = last_;
+            st_.last_q3_entry[idx] = -1;
+            levels_.push_back(last_ - 1, idx);
+        }
+
+        // Highest non-empty level first
+        current_level_ = levels_.first_non_empty();
+        return current_level_ == -1 ? -1 : levels_.pop_front(current_level_);
+    }
+
+    int quantum(int idx, int) {
+        current_quantum_ = (current_level_ < last_) ? params_.mlfq_quanta[current_level_] : st_.rem[idx];
+        return (st_.rem[idx] < current_quantum_) ? st_.rem[idx] : current_quantum_;
+    }
+
+    void on_preempt(int idx, int t, int ran) {
+        if (current_level_ == last_) return; // Unreachable: the FCFS level runs to completion
+        if (ran < current_quantum_) {
+            // Finished segment early (re-enqueue in same level)
+            levels_.push_back(current_level_, idx);
+        } else {
+            // Quantum expired -> Demote
+            int next_level = current_level_ + 1;
+            st_.queue_id[idx] = next_level + 1;
+            levels_.push_back(next_level, idx);
+            if (next_level == last_) st_.last_q3_entry[idx] = t;
+        }
+    }
+
+    void on_complete(int, int) {}
+    void on_block(int, int) {}
+    int reselect(int idx, int) { return idx; } // Arrivals never preempt
+
+    void grow(int capacity) { levels_.grow(st_.scratch, capacity); }
+
+private:
+    const SchedParams& params_;
+    SimState& st_;
+    int last_; // FCFS level (0-based); queue_id is level + 1
+    FifoLevels levels_;
+    int current_level_ = -1;
+    int current_quantum_ = 0;
+};
+
+// MLQ (Code 7): fixed queue per process with strict priority Q1 > Q2 > Q3; Q1 is priority
+// preemptive, Q2 round robin, Q3 FCFS, and a Q1 arrival preempts Q2/Q3.
+class MlqPolicy {
+public:
+    static const bool kIndexOrder = false; // AT order is FCFS order for Q3; Q2 reorders its share
+    static const bool kAdmitAfterRun = false;
+
+    MlqPolicy(const SchedParams& params, SimState& st, const ArrivalCursor& arrivals)
+        : params_(params), st_(st), arrivals_(arrivals),
+          q1_ready_(st.scratch, (int)st.at.size(), MlqPriorityOrder{&st}),
+          q2_ready_(st.scratch.take(st.at.size(), 0), (int)st.at.size()),
+          q3_ready_(st.scratch.take(st.at.size(), 0), (int)st.at.size()),
+          q2_batch_(st.scratch.take(st.at.size(), 0)) {}
+
+    void on_arrival(const std::vector<int>& batch, int t) {
+        while (!q1_wakes_.empty() && q1_wakes_.front().first <= t) {
+            std::pop_heap(q1_wakes_.begin(), q1_wakes_.end(), std::greater<std::pair<int, int>>());
+            q1_wakes_.pop_back();
+        }
+        // Q2 enqueues one batch in input order, like the RR scheduler.
+        int q2_count = 0;
+        for(int i : batch) {
+            int target_q = st_.queue_id[i]; 
+            if (target_q == 1) q1_ready_.push(i);
+            else if (target_q == 2) q2_batch_[q2_count++] = i;
+            else q3_ready_.push_back(i);
+        }
+        if (!std::is_sorted(q2_batch_, q2_batch_ + q2_count)) std::sort(q2_batch_, q2_batch_ + q2_count);
+        for(int k = 0; k < q2_count; k++) q2_ready_.push_back(q2_batch_[k]);
+    }
+
+    int select(int) {
+        // Strict Priority Selection (Q1 > Q2 > Q3)
+        if (!q1_ready_.empty()) {
+            current_q_ = 1;
+            return q1_ready_.top(); // Highest priority process; stays queued while it runs
+        }
+        if (!q2_ready_.empty()) {
+            current_q_ = 2;
+            return q2_ready_.pop_front(); // Dequeue RR
+        }
+        if (!q3_ready_.empty()) {
+            current_q_ = 3;
+            return q3_ready_.pop_front(); // Dequeue FCFS
+        }
+        return -1;
+    }
+
+    int quantum(int idx, int t) const {
+        int run_time;
+        if (current_q_ == 1) { // Q1: Priority Preemptive (runs until completion or the next arrival)
+            // Arrivals during a Q1 run are admitted one arrival instant at a time, in AT order.
+            run_time = std::min(st_.rem[idx], next_arrival_time(st_, arrivals_) - t);
+        } else if (current_q_ == 2) { // Q2: Round Robin
+            run_time = std::min(st_.rem[idx], params_.mlq_q2_quantum);
+        } else { // Q3: FCFS (Run until completion)
+            run_time = st_.rem[idx];
+        }
+        
+        // --- MLQ Master Preemption Check (Q1 arrivals preempt Q2/Q3) ---
+        int next_switch_time = t + run_time;
+        int k = first_gated_arrival<false>(st_.arr_at.data(), st_.arr_key.data(), (int)arrivals_.pos,
+                                           (int)arrivals_.order.size(), next_switch_time, 2);
+        if (k != -1) next_switch_time = st_.arr_at[k];
+        if (!q1_wakes_.empty()) next_switch_time = std::min(next_switch_time, q1_wakes_.front().first);
+        return next_switch_time - t;
+    }
+
+    void on_preempt(int idx, int, int) {
+        // Re-enqueue (Preemption or Quantum expiration)
+        if (current_q_ == 2) {
+            q2_ready_.push_back(idx); // RR
+        } else if (current_q_ == 3) {
+            q3_ready_.push_front(idx); // FCFS: preempted head resumes first
+        }
+        // Q1 processes are not dequeued until completion, no re-enqueue needed here.
+    }
+
+    void on_complete(int idx, int) {
+        if (current_q_ == 1) q1_ready_.remove(idx);
+    }
+
+    void on_block(int idx, int t) {
+        on_complete(idx, t);
+        // Its wake-up preempts Q2/Q3 just like a Q1 arrival
+        if (st_.queue_id[idx] == 1) {
+            q1_wakes_.push_back({st_.at[idx], idx});
+            std::push_heap(q1_wakes_.begin(), q1_wakes_.end(), std::greater<std::pair<int, int>>());
+        }
+    }
+
+    int reselect(int idx, int t) {
+        // Only Q1 preempts: a better Q1 process, or any Q1 process over a Q2/Q3 one
+        bool preempted = (current_q_ == 1) ? q1_ready_.top() != idx : !q1_ready_.empty();
+        if (!preempted) return idx;
+        on_preempt(idx, t, 0);
+        return select(t);
+    }
+
+    void grow(int capacity) {
+        q1_ready_.grow(st_.scratch, capacity);
+        q2_ready_.grow(st_.scratch.take(capacity, 0), capacity);
+        q3_ready_.grow(st_.scratch.take(capacity, 0), capacity);
+        q2_batch_ = st_.scratch.take(capacity, 0);
+    }
+
+private:
+    const SchedParams& params_;
+    SimState& st_;
+    const ArrivalCursor& arrivals_;
+    IndexedHeap<MlqPriorityOrder> q1_ready_; // Priority P
+    RingBuffer q2_ready_; // RR (Q=mlq_q2_quantum)
+    RingBuffer q3_ready_; // FCFS
+    int* q2_batch_; // Q2 share of the current arrival batch
+    std::vector<std::pair<int, int>> q1_wakes_; // (wake-up, process) min-heap of Q1 processes in I/O
+    int current_q_ = -1;
+};
+
+// Zero-length bursts never reach the CPU; they finish on arrival so the event loop can
+// terminate. Returns how many there were.
+static int complete_zero_bursts(SimState& st) {
+    int completed = 0;
+    for(size_t i=0; i<st.rem.size(); i++) {
+        if(st.rem[i] == 0) {
+            st.ct[i] = st.at[i];
+            completed++;
+        }
+    }
+    return completed;
+}
+
+// Runs one schedule over the input into st. arrival_order comes from build_arrival_order
+// over the same processes.
+static void simulate(
+    const InputView& input,
+    int algorithm_code,
+    int quantum, 
+    const SchedParams& params,
+    const std::vector<int>& arrival_order,
+    SimState& st,
+    GanttWriter& writer
+) {
+    st.reset(input, algorithm_code);
+    int completed = complete_zero_bursts(st);
+    if(algorithm_code == 5 && quantum < 1) quantum = 1;
+
+    ArrivalCursor arrivals(arrival_order);
+    IoEvents io;
+    if (input.io) {
+        io.reset(input, st);
+        arrivals.io = &io;
+    }
+    if (uses_horizon_columns(algorithm_code)) build_horizon_columns(st, arrival_order, algorithm_code);
+    auto run_kernel = [&](auto&& policy) { run_policy(input, params, st, arrivals, completed, writer, policy); };
+    
+    // 0: FCFS, 1: SJF, 2: SRTF, 3: Prio-NP, 4: Prio-P, 5: RR, 6: MLFQ, 7: MLQ
+    switch (algorithm_code) {
+        case 1: run_kernel(ReadyQueuePolicy<1>(params, st, arrivals)); break;
+        case 2: run_kernel(ReadyQueuePolicy<2>(params, st, arrivals)); break;
+        case 3: run_kernel(ReadyQueuePolicy<3>(params, st, arrivals)); break;
+        case 4: run_kernel(ReadyQueuePolicy<4>(params, st, arrivals)); break;
+        case 5: run_kernel(RoundRobinPolicy(quantum, st, arrivals)); break;
+        case 6: run_kernel(MlfqPolicy(params, st)); break;
+        case 7: run_kernel(MlqPolicy(params, st, arrivals)); break;
+        default: run_kernel(ReadyQueuePolicy<0>(params, st, arrivals)); break; // FCFS
+    }
+
+    writer.finish();
+    SCHED_PROFILE_COUNT(segments, writer.total());
+}
+
+// --- Gantt sizing ---
+// Upper bound on the merged segments a run can produce, derived from the input alone.
+// Every segment starts at an idle gap, a completion, an arrival that cuts a slice short,
+// a quantum expiry or (Prio-P) an aging step; each term below counts one of those.
+static long long gantt_segment_bound(const InputView& input, int algorithm_code, int quantum, const SchedParams& params) {
+    int n = input.n;
+    // With I/O plans every CPU burst counts as a process of its own: it arrives (or wakes
+    // up) once and completes (or blocks) once
+    long long active = 0, total_burst = 0, total_io = 0, slices = 0, aging_steps = 0;
+    int max_at = 0;
+    for (int i = 0; i < n; i++) {
+        if (input.bt(i) > 0) {
+            total_io += input.for_each_cpu_burst(i, [&](int burst) {
+                active++;
+                total_burst += burst;
+            });
+            max_at = std::max(max_at, input.at(i));
+        }
+    }
+    // Past the last arrival, the CPU only idles while some device is busy
+    long long makespan = max_at + total_burst + total_io;
+    if (params.has_overhead()) makespan = LLONG_MAX / 2; // Overhead stretches the run; rely on the priority cap
+    if (algorithm_code == 5 && quantum < 1) quantum = 1;
+    // MLFQ: the level above FCFS is revisited after each promotion
+    int mlfq_rr_levels = (int)params.mlfq_quanta.size();
+    long long promoted_quantum = mlfq_rr_levels > 0 ? params.mlfq_quanta.back() : 1;
+
+    for (int i = 0; i < n; i++) {
+        int bt = input.bt(i);
+        if (bt <= 0) continue;
+        if (algorithm_code == 4) {
+            // A waiting process only ages while its priority is above 1 and the run lasts
+            long long steps = std::min<long long>(input.priority(i, 4) - 1, (makespan - input.at(i)) / params.aging_rate);
+            aging_steps += std::max(0LL, steps);
+        } else if (algorithm_code == 5) {
+            // Slices that end on quantum expiry
+            input.for_each_cpu_burst(i, [&](int burst) { slices += (burst - 1) / quantum; });
+        } else if (algorithm_code == 6 && mlfq_rr_levels > 0) {
+            // One slice per level above it, plus every visit to the level above FCFS
+            long long cpu = 0;
+            input.for_each_cpu_burst(i, [&](int burst) { cpu += burst; });
+            slices += (mlfq_rr_levels - 1) + (cpu + promoted_quantum - 1) / promoted_quantum;
+        } else if (algorithm_code == 7 && std::min(3, std::max(1, input.priority(i, 7))) == 2) {
+            input.for_each_cpu_burst(i, [&](int burst) { slices += (burst - 1) / params.mlq_q2_quantum; });
+        }
+    }
+
+    // Idle gaps, slice-cutting arrivals and completions are each at most one per process
+    long long bound = 3 * active + slices + aging_steps;
+    if (algorithm_code == 0 || algorithm_code == 1 || algorithm_code == 3) bound = 2 * active;
+    // Every dispatch can add a switch and a warm-up segment. Besides the process segments,
+    // a dispatch is only repeated when its switch overlaps a preempting arrival or aging step.
+    if (params.has_overhead()) bound = 3 * bound + 2 * (active + aging_steps);
+    return bound;
+}
+
+// --- SMP simulation ---
+// M CPUs, each with its own run queue, advanced together on one event clock. Arrivals are
+// placed by the balancing mode (or their affinity); a CPU that frees up runs the best
+// process of its own queue and, with SMP_BALANCE_STEAL, pulls from the busiest CPU when
+// its queue is empty. Local order per CPU follows the algorithm: FCFS by AT, SJF/SRTF by
+// remaining time, Priority by base priority (no aging), RR as a FIFO with a quantum.
+// SRTF and Prio-P preempt when a better process arrives on the same CPU.
+// Switch and warm-up overhead work as on one CPU (see dispatch_with_overhead): a CPU in
+// the middle of a switch is not preempted, and checks its queue once the switch is over.
+
+// Balancing modes for SmpConfig.balance
+#define SMP_BALANCE_STATIC 0 // Arrivals dealt to the CPUs in turn; no migration
+#define SMP_BALANCE_PUSH 1   // Each arrival goes to the least loaded CPU
+#define SMP_BALANCE_STEAL 2  // PUSH, and an idle CPU steals from the busiest run queue
+
+struct SmpConfig {
+    int num_cpus;
+    int balance;           // SMP_BALANCE_*
+    const int* affinity;   // CPU each process is pinned to (-1 = any), or NULL for none
+    int switch_cost;       // Ticks to switch a CPU to a different process
+    int resume_penalty;    // Warm-up ticks for a process resuming on the CPU it last ran on
+    int migration_penalty; // Warm-up ticks for a process resuming on a different CPU
+};
+
+// One merged Gantt segment of an SMP run.
+struct SmpGanttLog {
+    int cpu;
+    int pid;
+    int start;
+    int finish;
+};
+
+// Per-CPU segment merging into one bounded buffer, like GanttWriter. Segments are written
+// as they close, so the buffer is ordered by close time rather than by CPU.
+class SmpGanttWriter {
+public:
+    SmpGanttWriter(SmpGanttLog* logs, int capacity, int num_cpus)
+        : logs_(logs), capacity_(capacity), open_(num_cpus, SmpGanttLog{0, 0, 0, 0}), has_open_(num_cpus, 0) {}
+
+    void add(int cpu, int pid, int start, int finish) {
+        SmpGanttLog& seg = open_[cpu];
+        if (has_open_[cpu] && seg.pid == pid && seg.finish == start) {
+            seg.finish = finish;
+            return;
+        }
+        if (has_open_[cpu]) emit(seg);
+        seg = {cpu, pid, start, finish};
+        has_open_[cpu] = 1;
+    }
+
+    void finish() {
+        for (size_t cpu = 0; cpu < open_.size(); cpu++) {
+            if (has_open_[cpu]) emit(open_[cpu]);
+            has_open_[cpu] = 0;
+        }
+    }
+
+    int total() const { return total_; }
+    int stored() const { return stored_; }
+
+private:
+    void emit(const SmpGanttLog& seg) {
+        total_++;
+        if (stored_ < capacity_) logs_[stored_++] = seg;
+    }
+
+    SmpGanttLog* logs_;
+    int capacity_;
+    std::vector<SmpGanttLog> open_;
+    std::vector<char> has_open_;
+    int stored_ = 0;
+    int total_ = 0;
+};
+
+// Run-queue order on one CPU: the policy key fixed at enqueue time, then AT, then index.
+struct SmpOrder {
+    const std::vector<int>* key;
+    const SimState* st;
+
+    // std heaps keep the largest element on top, so "greater" yields a min-heap
+    bool operator()(int a, int b) const {
+        if ((*key)[a] != (*key)[b]) return (*key)[a] > (*key)[b];
+        if (st->at[a] != st->at[b]) return st->at[a] > st->at[b];
+        return a > b;
+    }
+};
+
+class SmpEngine {
+public:
+    SmpEngine(const InputView& input, int algorithm_code, int quantum, const SmpConfig& smp, SimState& st, SmpGanttWriter& writer)
+        : input_(input), code_(algorithm_code), quantum_(std::max(1, quantum)), smp_(smp), st_(st), writer_(writer),
+          m_(smp.num_cpus), key_(st.at.size()), last_cpu_(st.at.size(), -1), order_{&key_, &st}, cpus_(smp.num_cpus) {}
+
+    void run(const std::vector<int>& arrival_order, int completed) {
+        int n = std::max(0, input_.n);
+        ArrivalCursor arrivals(arrival_order);
+        std::vector<int> batch;
+        completed_ = completed;
+
+        while (completed_ < n) {
+            // Next event: an arrival or the end of a running slice
+            int t = next_arrival_time(st_, arrivals);
+            for (const Cpu& cpu : cpus_) {
+                if (cpu.running != -1) t = std::min(t, cpu.slice_end);
+            }
+
+            for (int c = 0; c < m_; c++) {
+                if (cpus_[c].running != -1 && !cpus_[c].switching && cpus_[c].slice_end == t) stop(c, t);
+            }
+
+            take_arrivals(st_, arrivals, t, false, batch);
+            for (int i : batch) admit(i, t);
+
+            for (int c = 0; c < m_; c++) {
+                if (cpus_[c].switching && cpus_[c].slice_end == t) end_switch(c, t);
+            }
+            for (int c = 0; c < m_; c++) {
+                if (cpus_[c].running == -1) dispatch(c, t);
+            }
+        }
+        writer_.finish();
+    }
+
+private:
+    struct Cpu {
+        int running = -1;
+        bool switching = false; // running is not started yet: the switch overhead ends at slice_end
+        int last = -1;          // Process whose context the CPU holds
+        int slice_start = 0;
+        int slice_end = 0;
+        std::vector<int> pinned;     // Run queue entries bound to this CPU
+        std::vector<int> migratable; // Run queue entries other CPUs may steal
+        int load() const { return (int)(pinned.size() + migratable.size()) + (running != -1); }
+    };
+
+    bool preemptive() const { return code_ == 2 || code_ == 4; }
+
+    int pinned_cpu(int i) const {
+        int a = smp_.affinity ? smp_.affinity[i] : -1;
+        return (a >= 0 && a < m_) ? a : -1;
+    }
+
+    // Local order key of i as of now
+    int key_of(int i) {
+        if (code_ == 1 || code_ == 2) return st_.rem[i];
+        if (code_ == 3 || code_ == 4) return st_.base_prio[i];
+        if (code_ == 5) return next_seq_++;
+        return st_.at[i];
+    }
+
+    void enqueue(int c, int i) {
+        key_[i] = key_of(i);
+        std::vector<int>& q = (pinned_cpu(i) == c) ? cpus_[c].pinned : cpus_[c].migratable;
+        q.push_back(i);
+        std::push_heap(q.begin(), q.end(), order_);
+    }
+
+    static int pop(std::vector<int>& q, const SmpOrder& order) {
+        std::pop_heap(q.begin(), q.end(), order);
+        int i = q.back();
+        q.pop_back();
+        return i;
+    }
+
+    // Ends the slice running on c at t and re-queues the process there if work is left.
+    void stop(int c, int t) {
+        Cpu& cpu = cpus_[c];
+        int r = cpu.running;
+        cpu.running = -1;
+        st_.rem[r] -= t - cpu.slice_start;
+        writer_.add(c, input_.pid(r), cpu.slice_start, t);
+        if (st_.rem[r] == 0) {
+            completed_++;
+            st_.ct[r] = t;
+            st_.queue_id[r] = c; // Reported as the CPU the process finished on
+        } else {
+            enqueue(c, r);
+        }
+    }
+
+    void admit(int i, int t) {
+        int c = pinned_cpu(i);
+        if (c == -1 && smp_.balance == SMP_BALANCE_STATIC) {
+            c = next_static_cpu_;
+            next_static_cpu_ = (next_static_cpu_ + 1) % m_;
+        } else if (c == -1) {
+            c = 0;
+            for (int k = 1; k < m_; k++) {
+                if (cpus_[k].load() < cpus_[c].load()) c = k;
+            }
+        }
+        enqueue(c, i);
+
+        // A better arrival preempts the process running on its CPU
+        Cpu& cpu = cpus_[c];
+        if (preemptive() && cpu.running != -1 && !cpu.switching) {
+            int r = cpu.running;
+            int running_key = (code_ == 2) ? st_.rem[r] - (t - cpu.slice_start) : st_.base_prio[r];
+            if (key_[i] < running_key) stop(c, t); // Slices start before admission, so this one ran > 0
+        }
+    }
+
+    // Best entry of c's own run queues, or -1
+    int local_best(const Cpu& cpu) const {
+        if (cpu.pinned.empty()) return cpu.migratable.empty() ? -1 : cpu.migratable.front();
+        if (cpu.migratable.empty()) return cpu.pinned.front();
+        return order_(cpu.migratable.front(), cpu.pinned.front()) ? cpu.pinned.front() : cpu.migratable.front();
+    }
+
+    // The switch into cpu.running is over: start its slice, unless a better process arrived
+    // on c meanwhile, in which case it goes back to the queue and c dispatches again.
+    void end_switch(int c, int t) {
+        Cpu& cpu = cpus_[c];
+        int i = cpu.running;
+        cpu.switching = false;
+        if (preemptive()) {
+            int best = local_best(cpu);
+            int key = (code_ == 2) ? st_.rem[i] : st_.base_prio[i];
+            if (best != -1 && key_[best] < key) {
+                cpu.running = -1;
+                enqueue(c, i);
+                return;
+            }
+        }
+        start(c, i, t);
+    }
+
+    void start(int c, int i, int t) {
+        Cpu& cpu = cpus_[c];
+        if (st_.first_run[i] == -1) st_.first_run[i] = t;
+        last_cpu_[i] = c;
+        cpu.running = i;
+        cpu.slice_start = t;
+        cpu.slice_end = t + ((code_ == 5) ? std::min(st_.rem[i], quantum_) : st_.rem[i]);
+    }
+
+    // Writes the overhead of c taking over i and returns when i can start.
+    int charge_switch(int c, int i, int t) {
+        Cpu& cpu = cpus_[c];
+        if (cpu.last == i) return t;
+        cpu.last = i;
+        if (smp_.switch_cost > 0) {
+            writer_.add(c, GANTT_PID_SWITCH, t, t + smp_.switch_cost);
+            t += smp_.switch_cost;
+        }
+        if (st_.first_run[i] != -1) {
+            bool migrated = last_cpu_[i] != c;
+            int penalty = migrated ? smp_.migration_penalty : smp_.resume_penalty;
+            if (penalty > 0) {
+                writer_.add(c, migrated ? GANTT_PID_MIGRATION : GANTT_PID_WARMUP, t, t + penalty);
+                t += penalty;
+            }
+        }
+        return t;
+    }
+
+    void dispatch(int c, int t) {
+        Cpu& cpu = cpus_[c];
+        int i = -1;
+        bool has_pinned = !cpu.pinned.empty(), has_migratable = !cpu.migratable.empty();
+        if (has_pinned && (!has_migratable || order_(cpu.migratable.front(), cpu.pinned.front()))) {
+            i = pop(cpu.pinned, order_);
+        } else if (has_migratable) {
+            i = pop(cpu.migratable, order_);
+        } else if (smp_.balance == SMP_BALANCE_STEAL) {
+            int victim = -1;
+            for (int k = 0; k < m_; k++) {
+                if (k != c && !cpus_[k].migratable.empty() &&
+                    (victim == -1 || cpus_[k].migratable.size() > cpus_[victim].migratable.size())) victim = k;
+            }
+            if (victim != -1) i = pop(cpus_[victim].migratable, order_);
+        }
+        if (i == -1) return;
+
+        int begin = charge_switch(c, i, t);
+        if (begin > t) {
+            cpu.running = i;
+            cpu.switching = true;
+            cpu.slice_end = begin;
+            return;
+        }
+        start(c, i, t);
+    }
+
+    const InputView& input_;
+    int code_;
+    int quantum_;
+    const SmpConfig& smp_;
+    SimState& st_;
+    SmpGanttWriter& writer_;
+    int m_;
+    std::vector<int> key_;
+    std::vector<int> last_cpu_; // CPU each process last ran on, -1 before its first slice
+    SmpOrder order_;
+    std::vector<Cpu> cpus_;
+    int completed_ = 0;
+    int next_seq_ = 0;
+    int next_static_cpu_ = 0;
+};
+
+// Upper bound on the merged SMP segments: slices end on completion, on a preempting
+// arrival (at most one per arrival) or, for RR, on quantum expiry. With overhead, every
+// dispatch can add a switch and a warm-up segment, and a switch that a preempting arrival
+// overlaps is repeated.
+static long long smp_segment_bound(const Process* procs, int n, int algorithm_code, int quantum, const SmpConfig* smp) {
+    long long bound = 0, active = 0;
+    quantum = std::max(1, quantum);
+    for (int i = 0; i < n; i++) {
+        if (procs[i].bt <= 0) continue;
+        bound += 2;
+        active++;
+        if (algorithm_code == 5) bound += (procs[i].bt - 1) / quantum;
+    }
+    if (smp && (smp->switch_cost > 0 || smp->resume_penalty > 0 || smp->migration_penalty > 0)) bound = 3 * bound + 2 * active;
+    return bound;
+}
+
+// --- Batch runs ---
+// One simulation request within run_scheduler_batch. Outputs are optional.
+struct BatchJob {
+    int algorithm_code;
+    int quantum;
+    const int* mlq_queues; // MLQ only: queue id (1-3) per process, or NULL to read it from priority
+    GanttLog* logs;        // Merged Gantt segments (first max_logs are kept), or NULL
+    int max_logs;
+    Process* results;      // n processes with ct/tat/wt/first_run/... filled in, or NULL
+    const SchedulerConfig* config; // Scheduler parameters, or NULL for the defaults
+};
+
+// Per-job summary, matching what the UI derives from the result table and timeline.
+struct BatchResult {
+    int segments;         // Merged Gantt segments the run produced (may exceed max_logs)
+    int makespan;         // Latest completion time
+    int idle_time;
+    int context_switches; // Process segments beyond one per process
+    double avg_tat;
+    double avg_wt;
+    double avg_rt;        // Response time: first_run - at
+    int switch_time;      // Ticks spent in context switches (SchedulerConfig.switch_cost)
+    int warmup_time;      // Ticks spent warming up resumed processes
+};
+
+static void summarize_run(const InputView& input, const SimState& st, const GanttWriter& writer, BatchResult& result) {
+    int n = input.n;
+    long long tat = 0, wt = 0, rt = 0;
+    int makespan = 0;
+    for (int i = 0; i < n; i++) {
+        int turnaround = st.ct[i] - st.at[i];
+        tat += turnaround;
+        wt += turnaround - std::max(0, input.bt(i));
+        if (st.first_run[i] != -1) rt += st.first_run[i] - st.at[i];
+        makespan = std::max(makespan, st.ct[i]);
+    }
+    result.segments = writer.total();
+    result.makespan = makespan;
+    result.idle_time = writer.idle_time();
+    result.context_switches = writer.context_switches(n);
+    result.avg_tat = n > 0 ? (double)tat / n : 0.0;
+    result.avg_wt = n > 0 ? (double)wt / n : 0.0;
+    result.avg_rt = n > 0 ? (double)rt / n : 0.0;
+    result.switch_time = writer.switch_time();
+    result.warmup_time = writer.warmup_time();
+}
+
+// Runs one batch job straight off the shared input, using the worker's state.
+static void run_batch_job(
+    const Process* procs,
+    int n,
+    const BatchJob& job,
+    const std::vector<int>& arrival_order,
+    SimState& st,
+    BatchResult& result
+) {
+    InputView input = {procs, n, job.mlq_queues};
+    GanttWriter writer(job.logs, job.logs ? std::max(0, job.max_logs) : 0, nullptr, nullptr);
+    SchedParams params(job.config);
+    simulate(input, job.algorithm_code, job.quantum, params, arrival_order, st, writer);
+    summarize_run(input, st, writer, result);
+    if (job.results) write_results(input, st, job.results);
+}
+
+// Workers claim jobs one at a time from a shared counter, so long and short jobs
+// balance out. Every job writes only to its own buffers and result slot, which keeps
+// the output independent of which worker ran it. run_job(j, st) runs job j on the
+// worker's state.
+template <typename RunJob>
+static void run_batch_jobs(int num_jobs, int num_workers, const RunJob& run_job) {
+    num_workers = std::max(1, std::min(num_workers, num_jobs));
+    std::atomic<int> next_job(0);
+    auto worker = [&]() {
+        SimState st; // Per-worker scratch, reused from job to job
+        for (int j = next_job++; j < num_jobs; j = next_job++) run_job(j, st);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_workers - 1);
+    for (int w = 1; w < num_workers; w++) {
+        try {
+            threads.emplace_back(worker);
+        } catch (const std::system_error&) {
+            break; // No more threads: the ones running, and this one, still take every job
+        }
+    }
+    worker(); // The calling thread works too
+    for (std::thread& t : threads) t.join();
+}
+
+// --- Metrics-only runs ---
+// Sweeps that only need summary statistics skip the Gantt buffer entirely: the writer
+// still merges segments to count idle time and context switches, but stores none.
+
+// Log-linear histogram of non-negative values: exact below 128, then 64 buckets per power
+// of two, so a quantile read back is within 1/128 of the true value. Its size is fixed,
+// whatever the number of values added.
+class LogHistogram {
+public:
+    void clear() {
+        std::fill(counts_, counts_ + kBuckets, 0u);
+        count_ = 0;
+        min_ = INT_MAX;
+        max_ = 0;
+    }
+
+    void add(int v) {
+        v = std::max(0, v);
+        counts_[bucket(v)]++;
+        count_++;
+        min_ = std::min(min_, v);
+        max_ = std::max(max_, v);
+    }
+
+    // Nearest-rank quantile (q in [0, 1]), or 0 when empty.
+    double quantile(double q) const {
+        if (count_ == 0) return 0.0;
+        long long rank = std::max(1LL, (long long)std::ceil(q * count_));
+        long long seen = 0;
+        int b = 0;
+        while (b < kBuckets - 1 && (seen += counts_[b]) < rank) b++;
+        if (b < kExact) return b;
+        // Middle of the bucket, kept within the observed range
+        int shift = (b - kExact) / kSubBuckets + 1;
+        long long lower = (long long)(kSubBuckets + (b - kExact) % kSubBuckets) << shift;
+        double mid = lower + ((1LL << shift) - 1) / 2.0;
+        return std::min<double>(max_, std::max<double>(min_, mid));
+    }
+
+    int max() const { return count_ ? max_ : 0; }
+
+private:
+    static const int kExact = 128;
+    static const int kSubBuckets = 64;
+    static const int kBuckets = kExact + (31 - 7) * kSubBuckets;
+
+    static int bucket(int v) {
+        if (v < kExact) return v;
+        int shift = highest_set_bit((unsigned)v) - 6; // Keep the 7 leading bits
+        return kExact + (shift - 1) * kSubBuckets + ((v >> shift) - kSubBuckets);
+    }
+
+    unsigned counts_[kBuckets];
+    long long count_ = 0;
+    int min_ = INT_MAX;
+    int max_ = 0;
+};
+
+// Distribution of one per-process metric.
+struct MetricSummary {
+    double mean;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+};
+
+// Summary of one run, as app.py's analytics tab derives it from the table and timeline.
+struct SchedulerMetrics {
+    int processes;
+    int segments;         // Merged Gantt segments the run produced
+    int makespan;         // Latest completion time
+    int idle_time;
+    int context_switches; // Process segments beyond one per process
+    int switch_time;      // Ticks spent in context switches
+    int warmup_time;      // Ticks spent warming up resumed processes
+    double utilization;   // Share of [0, makespan] spent running processes, 0-1
+    double throughput;    // Processes completed per tick of makespan
+    MetricSummary wt;
+    MetricSummary tat;
+    MetricSummary rt;     // Response time: first_run - at (0 for zero-length bursts)
+};
+
+// Per-worker accumulator: one pass over the finished processes, constant memory.
+struct MetricsAccumulator {
+    LogHistogram wt, tat, rt;
+
+    void summarize(const InputView& input, const SimState& st, const GanttWriter& writer, SchedulerMetrics& out) {
+        wt.clear();
+        tat.clear();
+        rt.clear();
+        int n = std::max(0, input.n);
+        long long wt_sum = 0, tat_sum = 0, rt_sum = 0;
+        int makespan = 0;
+        for (int i = 0; i < n; i++) {
+            int turnaround = st.ct[i] - st.at[i];
+            int waiting = turnaround - std::max(0, input.bt(i));
+            int response = st.first_run[i] != -1 ? st.first_run[i] - st.at[i] : 0;
+            tat.add(turnaround);
+            wt.add(waiting);
+            rt.add(response);
+            tat_sum += turnaround;
+            wt_sum += waiting;
+            rt_sum += response;
+            makespan = std::max(makespan, st.ct[i]);
+        }
+        out.processes = n;
+        out.segments = writer.total();
+        out.makespan = makespan;
+        out.idle_time = writer.idle_time();
+        out.context_switches = writer.context_switches(n);
+        out.switch_time = writer.switch_time();
+        out.warmup_time = writer.warmup_time();
+        int busy = makespan - writer.idle_time() - writer.switch_time() - writer.warmup_time();
+        out.utilization = makespan > 0 ? (double)busy / makespan : 0.0;
+        out.throughput = makespan > 0 ? (double)n / makespan : 0.0;
+        fill(wt, wt_sum, n, out.wt);
+        fill(tat, tat_sum, n, out.tat);
+        fill(rt, rt_sum, n, out.rt);
+    }
+
+    static void fill(const LogHistogram& h, long long sum, int n, MetricSummary& out) {
+        out.mean = n > 0 ? (double)sum / n : 0.0;
+        out.p50 = h.quantile(0.50);
+        out.p95 = h.quantile(0.95);
+        out.p99 = h.quantile(0.99);
+        out.max = h.max();
+    }
+};
+
+// Runs one batch job without a Gantt buffer. The job's logs and results are ignored.
+static void run_metrics_job(
+    const Process* procs,
+    int n,
+    const BatchJob& job,
+    const std::vector<int>& arrival_order,
+    SimState& st,
+    MetricsAccumulator& acc,
+    SchedulerMetrics& out
+) {
+    InputView input = {procs, n, job.mlq_queues};
+    GanttWriter writer(nullptr, 0, nullptr, nullptr);
+    SchedParams params(job.config);
+    simulate(input, job.algorithm_code, job.quantum, params, arrival_order, st, writer);
+    acc.summarize(input, st, writer, out);
+}
+
+// --- Monte Carlo sweeps ---
+// Synthetic workloads are generated natively and fed straight into the metrics engine,
+// so a sweep over thousands of workloads never leaves C++. Workload w only depends on
+// (seed, w), so results do not depend on the worker count or on which worker ran it.
+#define ARRIVAL_POISSON 0 // Exponential gaps, arrival_rate arrivals per tick on average
+#define ARRIVAL_BURSTY 1  // Poisson clusters of burstiness arrivals on average, all at the same tick
+#define ARRIVAL_UNIFORM 2 // Uniform over [0, num_processes / arrival_rate], like app.py's generator
+
+#define BURST_UNIFORM 0     // Uniform over [1, 2 * burst_mean - 1]
+#define BURST_EXPONENTIAL 1
+#define BURST_PARETO 2      // Heavy tailed, alpha = burst_shape (> 1, default 1.5)
+#define BURST_LOGNORMAL 3   // sigma = burst_shape (default 1)
+
+// Random workload description. Fields <= 0 take the defaults in brackets.
+struct WorkloadSpec {
+    int num_processes;
+    int arrival_model;       // ARRIVAL_*
+    double arrival_rate;     // Mean arrivals per tick [1]
+    double burstiness;       // ARRIVAL_BURSTY: mean arrivals per cluster [4]
+    int burst_model;         // BURST_*
+    double burst_mean;       // Mean burst time [10]
+    double burst_shape;      // See BURST_PARETO / BURST_LOGNORMAL
+    int max_burst;           // Bursts are clamped to [1, max_burst] [100000]
+    int max_priority;        // Priorities are uniform over [1, max_priority] [10]
+    unsigned long long seed;
+};
+
+// Mean of one per-run metric over the workloads, with a Student t confidence interval.
+struct MetricInterval {
+    double mean;
+    double stddev; // Sample standard deviation across workloads
+    double low;
+    double high;
+};
+
+struct MonteCarloSummary {
+    int workloads;
+    MetricInterval avg_wt;
+    MetricInterval avg_tat;
+    MetricInterval avg_rt;
+    MetricInterval p99_wt;
+    MetricInterval p99_tat;
+    MetricInterval makespan;
+    MetricInterval utilization;
+    MetricInterval throughput;
+    MetricInterval context_switches;
+};
+
+#define MC_METRICS 9 // MetricInterval fields of MonteCarloSummary, in order
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3"). Each
+// block of four outputs is a pure function of the key and a counter, so every workload
+// gets an independent stream by putting its index in the upper counter words.
+class Philox {
+public:
+    Philox(uint64_t seed, uint64_t stream)
+        : key_{(uint32_t)seed, (uint32_t)(seed >> 32)}, counter_{0, 0, (uint32_t)stream, (uint32_t)(stream >> 32)} {}
+
+    uint32_t next() {
+        if (used_ == 4) refill();
+        return out_[used_++];
+    }
+
+    // Uniform double in (0, 1), never 0 so it can go through log()
+    double uniform() {
+        uint64_t bits = ((uint64_t)(next() >> 6) << 27) | (next() >> 5);
+        return (bits + 0.5) / 9007199254740992.0;
+    }
+
+    double exponential(double mean) { return -std::log(uniform()) * mean; }
+
+    double normal() {
+        const double kTwoPi = 6.283185307179586;
+        double r = std::sqrt(-2.0 * std::log(uniform()));
+        return r * std::cos(kTwoPi * uniform());
+    }
+
+private:
+    void refill() {
+        uint32_t c[4] = {counter_[0], counter_[1], counter_[2], counter_[3]};
+        uint32_t k[2] = {key_[0], key_[1]};
+        for (int round = 0; round < 10; round++) {
+            uint64_t p0 = (uint64_t)0xD2511F53u * c[0];
+            uint64_t p1 = (uint64_t)0xCD9E8D57u * c[2];
+            uint32_t next_c[4] = {(uint32_t)(p1 >> 32) ^ c[1] ^ k[0], (uint32_t)p1,
+                                  (uint32_t)(p0 >> 32) ^ c[3] ^ k[1], (uint32_t)p0};
+            std::copy(next_c, next_c + 4, c);
+            k[0] += 0x9E3779B9u;
+            k[1] += 0xBB67AE85u;
+        }
+        std::copy(c, c + 4, out_);
+        used_ = 0;
+        if (++counter_[0] == 0) counter_[1]++;
+    }
+
+    uint32_t key_[2];
+    uint32_t counter_[4];
+    uint32_t out_[4] = {0, 0, 0, 0};
+    int used_ = 4;
+};
+
+// Fills out with workload index of the spec, in arrival order (except ARRIVAL_UNIFORM).
+static void generate_workload_into(const WorkloadSpec& spec, uint64_t index, Process* out) {
+    Philox rng(spec.seed, index);
+    int n = spec.num_processes;
+    double rate = spec.arrival_rate > 0 ? spec.arrival_rate : 1.0;
+    double cluster = spec.burstiness >= 1 ? spec.burstiness : 4.0;
+    double mean = spec.burst_mean > 0 ? spec.burst_mean : 10.0;
+    int max_burst = spec.max_burst > 0 ? spec.max_burst : 100000;
+    int max_priority = spec.max_priority > 0 ? spec.max_priority : 10;
+    double alpha = spec.burst_shape > 1 ? spec.burst_shape : 1.5;
+    double sigma = spec.burst_shape > 0 ? spec.burst_shape : 1.0;
+    double span = n / rate;
+    const double kMaxTime = INT_MAX / 4; // Leaves room for the bursts after the last arrival
+
+    double t = 0.0;
+    int left_in_cluster = 0;
+    for (int i = 0; i < n; i++) {
+        double arrival;
+        if (spec.arrival_model == ARRIVAL_UNIFORM) {
+            arrival = std::floor(rng.uniform() * (span + 1));
+        } else if (spec.arrival_model == ARRIVAL_BURSTY) {
+            if (left_in_cluster == 0) {
+                // Cluster starts form a Poisson process; cluster sizes are geometric
+                t += rng.exponential(cluster / rate);
+                left_in_cluster = cluster > 1 ? 1 + (int)std::min(1e9, std::floor(std::log(rng.uniform()) / std::log(1.0 - 1.0 / cluster))) : 1;
+            }
+            left_in_cluster--;
+            arrival = t;
+        } else {
+            t += rng.exponential(1.0 / rate);
+            arrival = t;
+        }
+
+        double burst;
+        if (spec.burst_model == BURST_EXPONENTIAL) burst = std::ceil(rng.exponential(mean));
+        else if (spec.burst_model == BURST_PARETO) burst = std::ceil(mean * (alpha - 1) / alpha / std::pow(rng.uniform(), 1.0 / alpha));
+        else if (spec.burst_model == BURST_LOGNORMAL) burst = std::ceil(std::exp(std::log(mean) - sigma * sigma / 2 + sigma * rng.normal()));
+        else burst = 1 + std::floor(rng.uniform() * std::max(1.0, 2 * mean - 1));
+
+        Process& p = out[i];
+        std::memset(&p, 0, sizeof(p));
+        p.pid = i + 1;
+        p.at = (int)std::min(kMaxTime, std::floor(arrival));
+        p.bt = (int)std::max(1.0, std::min((double)max_burst, burst));
+        p.priority = p.base_priority = p.current_priority = 1 + (int)(rng.uniform() * max_priority);
+        p.rem_time = p.bt;
+        p.first_run = p.current_queue = p.last_q3_entry = -1;
+    }
+}
+
+// Standard normal quantile (Acklam's rational approximation, relative error < 1.2e-9).
+static double normal_quantile(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    if (p < 0.02425) {
+        double q = std::sqrt(-2 * std::log(p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    }
+    if (p > 1 - 0.02425) return -normal_quantile(1 - p);
+    double q = p - 0.5, r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+// Student t quantile with dof degrees of freedom, from the normal one by the
+// Cornish-Fisher expansion (within 1% for dof >= 3 at the usual confidence levels).
+static double student_t_quantile(double p, int dof) {
+    double z = normal_quantile(p), v = dof, z2 = z * z;
+    return z + z * (z2 + 1) / (4 * v) + z * ((5 * z2 + 16) * z2 + 3) / (96 * v * v) +
+           z * (((3 * z2 + 19) * z2 + 17) * z2 - 15) / (384 * v * v * v);
+}
+
+// Summarizes values (one per workload, in workload order so the sums are reproducible).
+static MetricInterval confidence_interval(const double* values, int count, double confidence) {
+    MetricInterval out = {0.0, 0.0, 0.0, 0.0};
+    if (count == 0) return out;
+    double sum = 0.0;
+    for (int k = 0; k < count; k++) sum += values[k];
+    out.mean = sum / count;
+    double squares = 0.0;
+    for (int k = 0; k < count; k++) squares += (values[k] - out.mean) * (values[k] - out.mean);
+    out.stddev = count > 1 ? std::sqrt(squares / (count - 1)) : 0.0;
+    double half = count > 1 ? student_t_quantile(0.5 + confidence / 2, count - 1) * out.stddev / std::sqrt((double)count) : 0.0;
+    out.low = out.mean - half;
+    out.high = out.mean + half;
+    return out;
+}
+
+static void monte_carlo_values(const SchedulerMetrics& m, double* values) {
+    const double picked[MC_METRICS] = {m.wt.mean, m.tat.mean, m.rt.mean, m.wt.p99, m.tat.p99, (double)m.makespan,
+                                       m.utilization, m.throughput, (double)m.context_switches};
+    std::copy(picked, picked + MC_METRICS, values);
+}
+
+// --- Gantt levels of detail ---
+// A pyramid over a finished single-CPU timeline, so a chart of [t0, t1] at N pixels costs
+// O(log n + N) however many segments the run produced. Level 0 splits the timeline into
+// power-of-two buckets about one segment long and records, per bucket, the process that
+// ran longest in it and the ticks spent running processes. Each further level halves the
+// bucket count by merging pairs; the merged dominant is the pair's dominant with the more
+// ticks (summed when both agree), which is exact at level 0 and an approximation above it.
+
+// A bucket of a query result, or a segment when the range is shown at full detail
+struct GanttLodSegment {
+    int pid;    // Process that ran longest in [start, finish), or a GANTT_PID_* value if none ran
+    int start;
+    int finish;
+    int busy;   // Ticks spent running processes; busy / (finish - start) is the utilization
+};
+
+struct GanttLod {
+    struct Bucket {
+        int pid;
+        int pid_time;
+        int busy;
+    };
+
+    std::vector<GanttLog> segments; // Positive-length segments, in time order
+    std::vector<long long> busy_prefix; // Busy ticks before each segment
+    int origin = 0;
+    int end = 0;
+    std::vector<long long> width;   // Bucket width of each level
+    std::vector<std::vector<Bucket>> levels;
+
+    // Returns false unless the segments are in time order and do not overlap.
+    bool build(const GanttLog* logs, int count) {
+        segments.reserve(count);
+        for (int k = 0; k < count; k++) {
+            if (logs[k].finish < logs[k].start) return false;
+            if (logs[k].finish == logs[k].start) continue;
+            if (!segments.empty() && logs[k].start < segments.back().finish) return false;
+            segments.push_back(logs[k]);
+        }
+        if (segments.empty()) return true;
+        busy_prefix.resize(segments.size() + 1, 0);
+        for (size_t k = 0; k < segments.size(); k++) {
+            const GanttLog& seg = segments[k];
+            busy_prefix[k + 1] = busy_prefix[k] + (seg.pid > 0 ? seg.finish - seg.start : 0);
+        }
+        origin = segments.front().start;
+        end = segments.back().finish;
+
+        long long span = (long long)end - origin;
+        long long w = 1;
+        while (w * (long long)segments.size() < span) w *= 2;
+        build_level0(w, (int)((span + w - 1) / w));
+        while (levels.back().size() > 1) {
+            const std::vector<Bucket>& fine = levels.back();
+            std::vector<Bucket> coarse((fine.size() + 1) / 2);
+            for (size_t b = 0; b < coarse.size(); b++) {
+                coarse[b] = fine[2 * b];
+                if (2 * b + 1 < fine.size()) merge(coarse[b], fine[2 * b + 1]);
+            }
+            width.push_back(width.back() * 2);
+            levels.push_back(std::move(coarse));
+        }
+        return true;
+    }
+
+    // Writes the view of [t0, t1) for pixels columns into out and returns the number of
+    // entries written (at most max_out; pixels + 2 always suffices). When at most pixels
+    // segments fall in the range they are returned as they are, clipped to the range;
+    // otherwise the buckets of the finest level at least (t1 - t0) / pixels wide, clipped
+    // likewise, with neighbours of the same dominant process merged.
+    int query(int t0, int t1, int pixels, GanttLodSegment* out, int max_out) const {
+        if (segments.empty() || t1 <= t0 || max_out <= 0) return 0;
+        pixels = std::max(1, pixels);
+        auto lo = std::upper_bound(segments.begin(), segments.end(), t0,
+                                   [](int t, const GanttLog& seg) { return t < seg.finish; });
+        auto hi = std::lower_bound(lo, segments.end(), t1,
+                                   [](const GanttLog& seg, int t) { return seg.start < t; });
+        int count = 0;
+        if (hi - lo <= pixels) {
+            for (auto it = lo; it != hi && count < max_out; ++it) {
+                int start = std::max(it->start, t0), finish = std::min(it->finish, t1);
+                out[count++] = {it->pid, start, finish, it->pid > 0 ? finish - start : 0};
+            }
+            return count;
+        }
+
+        long long target = ((long long)t1 - t0 + pixels - 1) / pixels;
+        size_t level = 0;
+        while (level + 1 < levels.size() && width[level] < target) level++;
+        long long w = width[level];
+        const std::vector<Bucket>& buckets = levels[level];
+        long long first = ((long long)std::max(t0, origin) - origin) / w;
+        long long last = std::min((long long)buckets.size(), ((long long)std::min(t1, end) - origin + w - 1) / w);
+        for (long long b = first; b < last; b++) {
+            const Bucket& bucket = buckets[b];
+            long long start = std::max<long long>(origin + b * w, t0);
+            long long finish = std::min<long long>(origin + (b + 1) * w, t1);
+            int busy = bucket.busy;
+            if (finish - start < w) busy = (int)(busy_before((int)finish) - busy_before((int)start)); // Clipped
+
+            if (count > 0 && out[count - 1].pid == bucket.pid) {
+                out[count - 1].finish = (int)finish;
+                out[count - 1].busy += busy;
+            } else if (count < max_out) {
+                out[count++] = {bucket.pid, (int)start, (int)finish, busy};
+            } else {
+                break;
+            }
+        }
+        return count;
+    }
+
+private:
+    long long busy_before(int t) const {
+        size_t k = std::upper_bound(segments.begin(), segments.end(), t,
+                                    [](int at, const GanttLog& seg) { return at < seg.finish; }) - segments.begin();
+        long long busy = busy_prefix[k];
+        if (k < segments.size() && segments[k].pid > 0 && segments[k].start < t) busy += t - segments[k].start;
+        return busy;
+    }
+
+    static void merge(Bucket& into, const Bucket& other) {
+        if (other.pid == into.pid) into.pid_time += other.pid_time;
+        else if (other.pid_time > into.pid_time) into.pid = other.pid, into.pid_time = other.pid_time;
+        into.busy += other.busy;
+    }
+
+    void build_level0(long long w, int num_buckets) {
+        width.push_back(w);
+        levels.emplace_back(num_buckets);
+        std::vector<std::pair<int, int>> ran; // (pid, ticks) of the bucket being filled
+        size_t first = 0;
+        for (int b = 0; b < num_buckets; b++) {
+            long long start = origin + b * w, finish = start + w;
+            while (first < segments.size() && segments[first].finish <= start) first++;
+            ran.clear();
+            int other_pid = GANTT_PID_IDLE, other_time = 0;
+            for (size_t k = first; k < segments.size() && segments[k].start < finish; k++) {
+                const GanttLog& seg = segments[k];
+                int ticks = (int)(std::min<long long>(seg.finish, finish) - std::max<long long>(seg.start, start));
+                if (seg.pid > 0) ran.push_back({seg.pid, ticks});
+                else if (ticks > other_time) other_pid = seg.pid, other_time = ticks;
+            }
+            Bucket& bucket = levels[0][b];
+            bucket = {other_pid, 0, 0};
+            std::sort(ran.begin(), ran.end());
+            for (size_t k = 0; k < ran.size();) {
+                int pid = ran[k].first, ticks = 0;
+                for (; k < ran.size() && ran[k].first == pid; k++) ticks += ran[k].second;
+                bucket.busy += ticks;
+                if (ticks > bucket.pid_time) bucket.pid = pid, bucket.pid_time = ticks;
+            }
+        }
+    }
+};
+
+// --- Reusable contexts ---
+// Everything a run allocates besides the caller's buffers. The state vectors, the arrival
+// order and the policy arena all keep their capacity between runs, so once a context has
+// seen a workload size, further runs of that size do no heap allocation at all.
+struct SchedulerContext {
+    SimState st;
+    std::vector<int> arrival_order;
+    SchedParams params{nullptr};
+};
+
+static int run_in_context(
+    SchedulerContext& ctx,
+    Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum,
+    const SchedulerConfig* config,
+    GanttLog* logs,
+    int max_logs,
+    int flags
+) {
+    InputView input = {procs, n, nullptr};
+    build_arrival_order(input, (flags & SCHED_FLAG_PRESORTED) != 0, ctx.arrival_order);
+    ctx.params.configure(config);
+    GanttWriter writer(logs, logs ? std::max(0, max_logs) : 0, nullptr, nullptr);
+    simulate(input, algorithm_code, quantum, ctx.params, ctx.arrival_order, ctx.st, writer);
+    write_results(input, ctx.st, procs);
+    return logs ? writer.stored() : writer.total();
+}
+
+// --- Binary traces ---
+// Columnar workload files for replaying traces of millions of processes without going
+// through Python. Every file starts with a TraceFileHeader followed by little-endian int32
+// data at the offsets the header lists:
+//   trace    HOSTRACE: at, bt, priority and optionally an MLQ queue column. With
+//            TRACE_FLAG_DELTA_AT the at column holds each gap to the previous arrival
+//            (the first entry is absolute), so the trace must be in arrival order.
+//   Gantt    HOSGANTT: count merged GanttLog records right after the header.
+//   results  HOSRESLT: ct, first_run and final queue columns, one entry per process.
+// The trace is memory-mapped and simulated in place, and both outputs are written
+// straight into mapped files.
+#define TRACE_VERSION 1
+#define TRACE_FLAG_DELTA_AT 1
+#define TRACE_COLUMNS 4
+
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t count;                  // Processes, or segments in a Gantt file
+    uint64_t columns[TRACE_COLUMNS]; // Byte offset of each int32 column, 0 when absent
+    uint64_t reserved;
+};
+
+// Trace and results column slots
+enum { TRACE_AT = 0, TRACE_BT = 1, TRACE_PRIORITY = 2, TRACE_QUEUE = 3 };
+enum { RESULT_CT = 0, RESULT_FIRST_RUN = 1, RESULT_QUEUE = 2 };
+
+// A whole file mapped into memory: read-only for traces, read-write for the outputs.
+// Outputs are created at their worst-case size and cut to what was written on close.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(size_); }
+
+    bool open_read(const char* path) { return open(path, false, 0); }
+    bool create(const char* path, uint64_t size) { return open(path, true, size); }
+
+    char* data() const { return data_; }
+    uint64_t size() const { return size_; }
+
+    // Unmaps the file, truncating a created file to final_size bytes.
+    bool close(uint64_t final_size) {
+        bool ok = true;
+#if defined(_WIN32)
+        if (data_) ok = UnmapViewOfFile(data_) != 0;
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) {
+            if (writable_) {
+                LARGE_INTEGER end;
+                end.QuadPart = (LONGLONG)final_size;
+                ok = ok && SetFilePointerEx(file_, end, nullptr, FILE_BEGIN) && SetEndOfFile(file_);
+            }
+            CloseHandle(file_);
+        }
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_) ok = munmap(data_, size_) == 0;
+        if (fd_ != -1) {
+            if (writable_) ok = ok && ftruncate(fd_, (off_t)final_size) == 0;
+            ::close(fd_);
+        }
+        fd_ = -1;
+#endif
+        data_ = nullptr;
+        size_ = 0;
+        return ok;
+    }
+
+private:
+    bool open(const char* path, bool writable, uint64_t size) {
+        writable_ = writable;
+#if defined(_WIN32)
+        file_ = CreateFileA(path, writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) return false;
+        if (!writable) {
+            LARGE_INTEGER file_size;
+            if (!GetFileSizeEx(file_, &file_size)) return false;
+            size = (uint64_t)file_size.QuadPart;
+        }
+        if (size == 0) return false;
+        mapping_ = CreateFileMappingA(file_, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                      (DWORD)(size >> 32), (DWORD)size, nullptr);
+        if (!mapping_) return false;
+        data_ = (char*)MapViewOfFile(mapping_, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, (SIZE_T)size);
+#else
+        fd_ = writable ? ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644) : ::open(path, O_RDONLY);
+        if (fd_ == -1) return false;
+        if (writable) {
+            if (ftruncate(fd_, (off_t)size) != 0) return false;
+        } else {
+            struct stat info;
+            if (fstat(fd_, &info) != 0) return false;
+            size = (uint64_t)info.st_size;
+        }
+        if (size == 0) return false;
+        void* mapped = mmap(nullptr, (size_t)size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd_, 0);
+        data_ = mapped == MAP_FAILED ? nullptr : (char*)mapped;
+#endif
+        if (data_) size_ = size;
+        return data_ != nullptr;
+    }
+
+#if defined(_WIN32)
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    char* data_ = nullptr;
+    uint64_t size_ = 0;
+    bool writable_ = false;
+};
+
+static void init_header(TraceFileHeader& header, const char* magic, uint64_t count) {
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.count = count;
+}
+
+// Points input at the columns of a mapped trace. Delta-encoded arrivals are decoded into
+// decoded_at, the only column that gets materialized. Returns false for a malformed trace.
+static bool bind_trace(const MappedFile& file, InputView& input, std::vector<int>& decoded_at, bool& presorted) {
+    if (file.size() < sizeof(TraceFileHeader)) return false;
+    TraceFileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, "HOSTRACE", 8) != 0 || header.version != TRACE_VERSION) return false;
+    if (header.count > (uint64_t)INT_MAX) return false;
+
+    int n = (int)header.count;
+    const int* columns[TRACE_COLUMNS] = {};
+    for (int c = 0; c < TRACE_COLUMNS; c++) {
+        uint64_t offset = header.columns[c];
+        if (offset == 0) {
+            if (c != TRACE_QUEUE) return false; // Only the queue column is optional
+            continue;
+        }
+        if (offset % sizeof(int) != 0 || offset < sizeof(header) || offset > file.size() ||
+            (file.size() - offset) / sizeof(int) < (uint64_t)n) return false;
+        columns[c] = (const int*)(file.data() + offset);
+    }
+
+    input = InputView{nullptr, n, columns[TRACE_QUEUE]};
+    input.at_column = columns[TRACE_AT];
+    input.bt_column = columns[TRACE_BT];
+    input.priority_column = columns[TRACE_PRIORITY];
+    presorted = false;
+    if (header.flags & TRACE_FLAG_DELTA_AT) {
+        decoded_at.resize(n);
+        long long at = 0;
+        for (int i = 0; i < n; i++) {
+            int delta = columns[TRACE_AT][i];
+            if (delta < 0 || (at += delta) > INT_MAX) return false;
+            decoded_at[i] = (int)at;
+        }
+        input.at_column = decoded_at.data();
+        presorted = true;
+    }
+    return true;
+}
+
+// Writes the ct/first_run/queue columns of a finished run into a mapped results file.
+static bool write_trace_results(const char* path, const SimState& st, int n) {
+    uint64_t column_bytes = (uint64_t)n * sizeof(int);
+    uint64_t size = sizeof(TraceFileHeader) + 3 * column_bytes;
+    MappedFile file;
+    if (!file.create(path, size)) return false;
+
+    TraceFileHeader header;
+    init_header(header, "HOSRESLT", (uint64_t)n);
+    const std::vector<int>* columns[3] = {&st.ct, &st.first_run, &st.queue_id};
+    for (int c = 0; c < 3; c++) {
+        header.columns[c] = sizeof(header) + c * column_bytes;
+        if (n > 0) std::memcpy(file.data() + header.columns[c], columns[c]->data(), column_bytes);
+    }
+    std::memcpy(file.data(), &header, sizeof(header));
+    return file.close(size);
+}
+
+// --- Online sessions ---
+// A session schedules a live feed: processes are submitted as they become known and the
+// schedule is advanced to a time bound, so the work done is proportional to the new
+// events and nothing is ever re-simulated. It runs the same policy objects as the batch
+// engine. Because every submission made after advance(T) arrives at T or later, all
+// decisions before T and every slice that ends by T are final; the one slice that runs
+// past T stays open and its end is recomputed, from its dispatch time, once later
+// arrivals are known. The timeline and the completions therefore match a batch run
+// over the same processes.
+struct SchedulerSession;
+
+// The session's policy, chosen at runtime.
+struct SessionKernel {
+    virtual ~SessionKernel() {}
+    virtual void advance(SchedulerSession& s) = 0;
+    virtual void grow(int capacity) = 0;
+};
+
+struct SchedulerSession {
+    int algorithm_code;
+    SchedParams params;
+    SimState st;
+    std::vector<int> arrival_order; // Pending suffix kept sorted by (at, submission)
+    ArrivalCursor arrivals{arrival_order};
+    std::vector<int> bt;       // Submitted bursts, indexed like st
+    std::vector<int> priority; // Submitted priorities (MLQ: queue id)
+    std::unique_ptr<SessionKernel> kernel;
+
+    int n = 0;
+    int capacity = 0;
+    int horizon = 0;      // Every future arrival is at or after this time
+    bool closed = false;
+    int current_time = 0;
+    int running = -1;     // Process of the open slice, or -1
+    int slice_start = 0;
+    int switching = -1;   // Process whose switch overhead ends at current_time, or -1
+    int last = -1;        // Process whose context the CPU holds
+
+    std::vector<GanttLog> chunk;
+    GanttWriter writer;
+    std::deque<GanttLog> segments; // Closed segments not yet drained
+    std::deque<int> completions;   // Finished processes not yet drained
+
+    SchedulerSession(int code, const SchedulerConfig* config)
+        : algorithm_code(code), params(config), chunk(256),
+          writer(chunk.data(), (int)chunk.size(), &SchedulerSession::collect, this) {}
+
+    static void collect(const GanttLog* logs, int count, void* user) {
+        SchedulerSession* s = static_cast<SchedulerSession*>(user);
+        s->segments.insert(s->segments.end(), logs, logs + count);
+    }
+
+    void reserve(int needed) {
+        if (needed <= capacity) return;
+        capacity = std::max(needed, std::max(64, 2 * capacity));
+        st.resize(capacity);
+        bt.resize(capacity);
+        priority.resize(capacity);
+        kernel->grow(capacity);
+    }
+
+    // Drops the admitted prefix of the arrival columns once it dominates them.
+    void compact_arrivals() {
+        size_t done = arrivals.pos;
+        if (done < 1024 || 2 * done < arrival_order.size()) return;
+        arrival_order.erase(arrival_order.begin(), arrival_order.begin() + done);
+        if (uses_horizon_columns(algorithm_code)) {
+            st.arr_at.erase(st.arr_at.begin(), st.arr_at.begin() + done);
+            st.arr_key.erase(st.arr_key.begin(), st.arr_key.begin() + done);
+        }
+        arrivals.pos = 0;
+    }
+
+    int submit(int at, int burst, int prio) {
+        if (closed || at < horizon || n == INT_MAX) return -1;
+        reserve(n + 1);
+        int i = n++;
+        bt[i] = burst;
+        priority[i] = prio;
+        st.init_process(i, at, burst, prio, algorithm_code);
+        if (st.rem[i] == 0) {
+            // Zero-length bursts finish on arrival, as in complete_zero_bursts
+            st.ct[i] = at;
+            completions.push_back(i);
+            return i + 1;
+        }
+        // Later arrivals at the same time queue up behind earlier submissions
+        std::vector<int>::iterator pos = std::upper_bound(
+            arrival_order.begin() + arrivals.pos, arrival_order.end(), at,
+            [&](int t, int j) { return t < st.at[j]; });
+        size_t k = pos - arrival_order.begin();
+        arrival_order.insert(pos, i);
+        if (uses_horizon_columns(algorithm_code)) {
+            st.arr_at.insert(st.arr_at.begin() + k, at);
+            st.arr_key.insert(st.arr_key.begin() + k, horizon_key(st, i, algorithm_code));
+        }
+        return i + 1;
+    }
+
+    void advance_to(int t) {
+        if (closed) return;
+        horizon = std::max(horizon, t);
+        compact_arrivals();
+        kernel->advance(*this);
+    }
+
+    void close() {
+        if (closed) return;
+        horizon = INT_MAX;
+        kernel->advance(*this);
+        closed = true;
+        writer.finish();
+    }
+
+    void fill_result(int i, Process& p) const {
+        p.pid = i + 1;
+        p.at = st.at[i];
+        p.bt = bt[i];
+        p.priority = p.base_priority = st.base_prio[i];
+        p.current_priority = st.prio[i];
+        p.rem_time = p.bt;
+        p.first_run = st.first_run[i];
+        p.ct = st.ct[i];
+        p.tat = p.ct - p.at;
+        p.wt = p.tat - std::max(0, p.bt);
+        p.current_queue = st.queue_id[i];
+        p.last_q3_entry = -1;
+    }
+};
+
+// The run_policy event loop, stopped at the session horizon and resumable.
+template <typename Policy>
+struct SessionKernelImpl : SessionKernel {
+    Policy policy;
+
+    template <typename... Args>
+    explicit SessionKernelImpl(Args&&... args) : policy(std::forward<Args>(args)...) {}
+
+    void grow(int capacity) override { policy.grow(capacity); }
+
+    void advance(SchedulerSession& s) override {
+        SimState& st = s.st;
+        std::vector<int>& batch = st.batch;
+        while (true) {
+            if (s.running != -1) {
+                int end = s.slice_start + policy.quantum(s.running, s.slice_start);
+                // A slice ending exactly at the horizon still waits when arrivals at its
+                // end are admitted before it is re-queued.
+                if (end > s.horizon || (end == s.horizon && Policy::kAdmitAfterRun && s.horizon != INT_MAX)) return;
+                finish_slice(s, end);
+                continue;
+            }
+            if (s.current_time >= s.horizon) return; // Arrivals at the horizon may still come
+
+            take_arrivals(st, s.arrivals, s.current_time, Policy::kIndexOrder, batch);
+            if (!batch.empty()) policy.on_arrival(batch, s.current_time);
+
+            int idx;
+            if (s.switching != -1) {
+                // The switch is over and every arrival it overlapped is known
+                idx = policy.reselect(s.switching, s.current_time);
+                s.switching = -1;
+            } else {
+                idx = policy.select(s.current_time);
+            }
+            if (idx == -1) {
+                int next_at = next_arrival_time(st, s.arrivals);
+                if (next_at == INT_MAX || next_at > s.horizon) return; // Idle until a later submission
+                s.writer.add(GANTT_PID_IDLE, s.current_time, next_at);
+                s.current_time = next_at;
+                continue;
+            }
+            start(s, idx);
+        }
+    }
+
+    // Dispatches idx, or starts its switch overhead (dispatch_with_overhead, one step at a time).
+    void start(SchedulerSession& s, int idx) {
+        if (s.params.has_overhead()) {
+            int t = charge_switch(s.params, s.st, s.writer, idx, s.last, s.current_time);
+            if (t != s.current_time) {
+                s.current_time = t;
+                s.switching = idx;
+                return;
+            }
+        }
+        if (s.st.first_run[idx] == -1) s.st.first_run[idx] = s.current_time;
+        s.running = idx;
+        s.slice_start = s.current_time;
+    }
+
+    void finish_slice(SchedulerSession& s, int end) {
+        SimState& st = s.st;
+        int idx = s.running;
+        int run_time = end - s.slice_start;
+        s.running = -1;
+        s.current_time = end;
+        st.rem[idx] -= run_time;
+        s.writer.add(idx + 1, s.slice_start, end);
+
+        if (Policy::kAdmitAfterRun) {
+            take_arrivals(st, s.arrivals, end, Policy::kIndexOrder, st.batch);
+            if (!st.batch.empty()) policy.on_arrival(st.batch, end);
+        }
+
+        if (st.rem[idx] == 0) {
+            st.ct[idx] = end;
+            policy.on_complete(idx, end);
+            s.completions.push_back(idx);
+        } else {
+            policy.on_preempt(idx, end, run_time);
+        }
+    }
+};
+
+static SessionKernel* make_session_kernel(SchedulerSession& s, int quantum) {
+    const SchedParams& params = s.params;
+    SimState& st = s.st;
+    const ArrivalCursor& arrivals = s.arrivals;
+    if (s.algorithm_code == 5 && quantum < 1) quantum = 1;
+    // 0: FCFS, 1: SJF, 2: SRTF, 3: Prio-NP, 4: Prio-P, 5: RR, 6: MLFQ, 7: MLQ
+    switch (s.algorithm_code) {
+        case 1: return new SessionKernelImpl<ReadyQueuePolicy<1>>(params, st, arrivals);
+        case 2: return new SessionKernelImpl<ReadyQueuePolicy<2>>(params, st, arrivals);
+        case 3: return new SessionKernelImpl<ReadyQueuePolicy<3>>(params, st, arrivals);
+        case 4: return new SessionKernelImpl<ReadyQueuePolicy<4>>(params, st, arrivals);
+        case 5: return new SessionKernelImpl<RoundRobinPolicy>(quantum, st, arrivals);
+        case 6: return new SessionKernelImpl<MlfqPolicy>(params, st);
+        case 7: return new SessionKernelImpl<MlqPolicy>(params, st, arrivals);
+        default: return new SessionKernelImpl<ReadyQueuePolicy<0>>(params, st, arrivals); // FCFS
+    }
+}
+
+// --- Reference engine ---
+#if defined(SCHEDULER_REFERENCE)
+#include "scheduler_reference.cpp"
+#endif
+
+extern "C" {
+// run_scheduler_ex with runtime scheduler parameters (config may be NULL for the defaults).
+SCHEDULER_API int run_scheduler_config(
+    Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum, 
+    const SchedulerConfig* config,
+    GanttLog* logs,
+    int max_logs,
+    int flags
+) {
+    SchedulerContext ctx;
+    return run_in_context(ctx, procs, n, algorithm_code, quantum, config, logs, max_logs, flags);
+}
+
+#if defined(SCHEDULER_INSTRUMENT)
+// Writes a Chrome trace (JSON), loadable in Perfetto or chrome://tracing: the engine's
+// phases on wall-clock time as one process, and the simulated timeline (count segments,
+// one simulated tick drawn as one microsecond) as another.
+static bool write_chrome_trace(const char* path, const Profiler& profiler, const GanttLog* logs, int count) {
+    static const char* const kPhaseNames[SCHED_PHASE_COUNT] = {
+        "arrival_sort", "arrivals", "select", "preempt_check", "aging", "gantt_merge", "results"};
+    static const char* const kOverheadNames[] = {"Idle", "Switch", "Warmup", "Migration"};
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+
+    const SchedulerProfile& stats = profiler.stats();
+    double us_per_tick = stats.tick_ns / 1000.0;
+    uint64_t origin = profiler.start_tick();
+    std::fprintf(f, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    std::fprintf(f, "{\"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"name\": \"process_name\", \"args\": {\"name\": \"scheduler engine\"}},\n");
+    std::fprintf(f, "{\"ph\": \"M\", \"pid\": 2, \"tid\": 1, \"name\": \"process_name\", \"args\": {\"name\": \"simulated CPU\"}},\n");
+    std::fprintf(f, "{\"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"name\": \"run\", \"ts\": 0, \"dur\": %.3f}",
+                 (profiler.finish_tick() - origin) * us_per_tick);
+    for (const Profiler::Event& e : profiler.events()) {
+        std::fprintf(f, ",\n{\"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"name\": \"%s\", \"ts\": %.3f, \"dur\": %.3f}",
+                     kPhaseNames[e.phase], (e.start - origin) * us_per_tick, (e.finish - e.start) * us_per_tick);
+    }
+    for (int k = 0; k < count; k++) {
+        const GanttLog& seg = logs[k];
+        char name[16];
+        if (seg.pid > 0) std::snprintf(name, sizeof(name), "P%d", seg.pid);
+        else if (seg.pid >= GANTT_PID_MIGRATION) std::snprintf(name, sizeof(name), "%s", kOverheadNames[-seg.pid - 1]);
+        else std::snprintf(name, sizeof(name), "%d", seg.pid);
+        std::fprintf(f, ",\n{\"ph\": \"X\", \"pid\": 2, \"tid\": 1, \"name\": \"%s\", \"ts\": %d, \"dur\": %lld}",
+                     name, seg.start, (long long)seg.finish - seg.start);
+    }
+    std::fprintf(f, "\n]}\n");
+    bool ok = !std::ferror(f);
+    return std::fclose(f) == 0 && ok;
+}
+#endif
+
+// Runs like run_scheduler_config and, when the library is built with SCHEDULER_INSTRUMENT,
+// fills profile (may be NULL) with per-phase ticks, event counts and the ready-queue
+// high-water mark. Unless trace_path is NULL it also writes a Chrome trace of the run
+// there (see write_chrome_trace). Built without instrumentation the run is not profiled:
+// profile comes back zeroed with enabled = 0 and no trace is written.
+// Returns what run_scheduler_config returns, or -2 if the trace file cannot be written.
+SCHEDULER_API int run_scheduler_profiled(
+    Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum,
+    const SchedulerConfig* config,
+    GanttLog* logs,
+    int max_logs,
+    int flags,
+    SchedulerProfile* profile,
+    const char* trace_path
+) {
+    SchedulerProfile stats;
+    std::memset(&stats, 0, sizeof(stats));
+#if defined(SCHEDULER_INSTRUMENT)
+    Profiler profiler(stats, trace_path != nullptr);
+    SchedulerContext ctx;
+    profiler.start();
+    int segments = run_in_context(ctx, procs, n, algorithm_code, quantum, config, logs, max_logs, flags);
+    profiler.stop();
+    if (profile) *profile = stats;
+    if (trace_path && !write_chrome_trace(trace_path, profiler, logs, logs ? segments : 0)) return -2;
+    return segments;
+#else
+    (void)trace_path;
+    if (profile) *profile = stats;
+    return run_scheduler_config(procs, n, algorithm_code, quantum, config, logs, max_logs, flags);
+#endif
+}
+
+// Creates a context for run_scheduler_context, or returns NULL when out of memory.
+// A context may be reused for any number of runs but by one thread at a time.
+SCHEDULER_API SchedulerContext* scheduler_context_create() {
+    return new (std::nothrow) SchedulerContext();
+}
+
+// Frees the scratch memory the context has grown to; the next run grows it again.
+SCHEDULER_API void scheduler_context_reset(SchedulerContext* ctx) {
+    if (ctx) *ctx = SchedulerContext();
+}
+
+SCHEDULER_API void scheduler_context_destroy(SchedulerContext* ctx) {
+    delete ctx;
+}
+
+// run_scheduler_config reusing ctx's memory. Returns -1 if ctx is NULL.
+SCHEDULER_API int run_scheduler_context(
+    SchedulerContext* ctx,
+    Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum,
+    const SchedulerConfig* config,
+    GanttLog* logs,
+    int max_logs,
+    int flags
+) {
+    if (!ctx) return -1;
+    return run_in_context(*ctx, procs, n, algorithm_code, quantum, config, logs, max_logs, flags);
+}
+
+// Writes the merged Gantt timeline straight into logs, keeping the first max_logs
+// segments, and returns how many were stored. With logs == NULL nothing is stored and
+// the exact number of segments the run produces is returned instead.
+SCHEDULER_API int run_scheduler_ex(
+    Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum, 
+    GanttLog* logs,
+    int max_logs,
+    int flags
+) {
+    return run_scheduler_config(procs, n, algorithm_code, quantum, nullptr, logs, max_logs, flags);
+}
+
+// scheduler_log_bound for a run with the given parameters (config may be NULL).
+SCHEDULER_API int scheduler_config_log_bound(
+    const Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum,
+    const SchedulerConfig* config
+) {
+    InputView input = {procs, n, nullptr};
+    SchedParams params(config);
+    return (int)std::min<long long>(INT_MAX, gantt_segment_bound(input, algorithm_code, quantum, params));
+}
+
+// Checks an IoPlan against the rules listed with it.
+static bool valid_io_plan(const IoPlan* io, int n) {
+    if (!io || !io->offsets || n < 0 || io->offsets[0] < 0) return false;
+    int num_devices = std::max(1, io->num_devices);
+    for (int i = 0; i < n; i++) {
+        int begin = io->offsets[i], end = io->offsets[i + 1];
+        if (end < begin) return false;
+        if (end == begin) continue; // Keeps bt
+        if (!io->bursts || (end - begin) % 2 == 0) return false;
+        if (end - begin == 1) { // CPU-only; a single burst may be 0 like bt
+            if (io->bursts[begin] < 0) return false;
+            continue;
+        }
+        for (int k = begin; k < end; k++) {
+            bool cpu = (k - begin) % 2 == 0;
+            if (cpu ? io->bursts[k] <= 0 : io->bursts[k] < 0) return false;
+            if (!cpu && io->devices && (io->devices[k] < 0 || io->devices[k] >= num_devices)) return false;
+        }
+    }
+    return true;
+}
+
+// run_scheduler_config for processes that alternate CPU and I/O bursts (see IoPlan). A
+// blocked process leaves the ready queues, waits for its device, and re-enters the
+// policy as an arrival of its next CPU burst; MLFQ keeps it at its level. The results
+// report bt as the total CPU time and wt as the time spent ready but not running, so
+// tat - wt - bt is the time blocked on I/O. Returns the same as run_scheduler_config,
+// or -1 if the plan is invalid.
+SCHEDULER_API int run_scheduler_io(
+    Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum,
+    const SchedulerConfig* config,
+    const IoPlan* io,
+    GanttLog* logs,
+    int max_logs,
+    int flags
+) {
+    if (!valid_io_plan(io, n)) return -1;
+    InputView input = {procs, n, nullptr};
+    input.io = io;
+    std::vector<int> arrival_order;
+    build_arrival_order(input, (flags & SCHED_FLAG_PRESORTED) != 0, arrival_order);
+    SchedParams params(config);
+    GanttWriter writer(logs, logs ? std::max(0, max_logs) : 0, nullptr, nullptr);
+    SimState st;
+    simulate(input, algorithm_code, quantum, params, arrival_order, st, writer);
+    write_results(input, st, procs);
+    return logs ? writer.stored() : writer.total();
+}
+
+// scheduler_config_log_bound for run_scheduler_io, or -1 if the plan is invalid.
+SCHEDULER_API int scheduler_io_log_bound(
+    const Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum,
+    const SchedulerConfig* config,
+    const IoPlan* io
+) {
+    if (!valid_io_plan(io, n)) return -1;
+    InputView input = {procs, n, nullptr};
+    input.io = io;
+    SchedParams params(config);
+    return (int)std::min<long long>(INT_MAX, gantt_segment_bound(input, algorithm_code, quantum, params));
+}
+
+// Guaranteed upper bound on the number of Gantt segments run_scheduler_ex will produce
+// for this input, computed in O(n) without simulating. A logs buffer of this size is
+// never truncated. Returns INT_MAX if the bound does not fit in an int.
+SCHEDULER_API int scheduler_log_bound(
+    const Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum
+) {
+    return scheduler_config_log_bound(procs, n, algorithm_code, quantum, nullptr);
+}
+
+// Streams the merged Gantt timeline through sink in chunks of up to chunk_capacity
+// segments, with no cap on the total. config may be NULL for the default parameters.
+// Returns the number of segments delivered, or -1 if no usable chunk buffer or sink was given.
+SCHEDULER_API int run_scheduler_stream(
+    Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum,
+    int flags,
+    GanttLog* chunk,
+    int chunk_capacity,
+    GanttSink sink,
+    void* user,
+    const SchedulerConfig* config
+) {
+    if (!chunk || chunk_capacity < 1 || !sink) return -1;
+    std::vector<int> arrival_order;
+    InputView input = {procs, n, nullptr};
+    build_arrival_order(input, (flags & SCHED_FLAG_PRESORTED) != 0, arrival_order);
+    SimState st;
+    SchedParams params(config);
+    GanttWriter writer(chunk, chunk_capacity, sink, user);
+    simulate(input, algorithm_code, quantum, params, arrival_order, st, writer);
+    write_results(input, st, procs);
+    return writer.total();
+}
+
+// Runs every job over the same read-only workload. The arrival sort is done once and
+// shared, and every job reads the processes in place. Returns the number of
+// jobs run, or -1 on invalid arguments.
+SCHEDULER_API int run_scheduler_batch(
+    const Process* procs,
+    int n,
+    const BatchJob* jobs,
+    int num_jobs,
+    BatchResult* results,
+    int flags
+) {
+    if (n < 0 || num_jobs < 0 || (n > 0 && !procs) || (num_jobs > 0 && (!jobs || !results))) return -1;
+
+    std::vector<int> arrival_order;
+    InputView input = {procs, n, nullptr};
+    build_arrival_order(input, (flags & SCHED_FLAG_PRESORTED) != 0, arrival_order);
+    run_batch_jobs(num_jobs, 1, [&](int j, SimState& st) {
+        run_batch_job(procs, n, jobs[j], arrival_order, st, results[j]);
+    });
+    return num_jobs;
+}
+
+// run_scheduler_batch spread over num_workers threads (<= 0 uses every hardware
+// thread). Results are identical to the single-threaded call.
+SCHEDULER_API int run_scheduler_batch_mt(
+    const Process* procs,
+    int n,
+    const BatchJob* jobs,
+    int num_jobs,
+    BatchResult* results,
+    int flags,
+    int num_workers
+) {
+    if (n < 0 || num_jobs < 0 || (n > 0 && !procs) || (num_jobs > 0 && (!jobs || !results))) return -1;
+
+    std::vector<int> arrival_order;
+    InputView input = {procs, n, nullptr};
+    build_arrival_order(input, (flags & SCHED_FLAG_PRESORTED) != 0, arrival_order);
+    if (num_workers <= 0) num_workers = std::max(1u, std::thread::hardware_concurrency());
+    run_batch_jobs(num_jobs, num_workers, [&](int j, SimState& st) {
+        run_batch_job(procs, n, jobs[j], arrival_order, st, results[j]);
+    });
+    return num_jobs;
+}
+
+// Runs every job like run_scheduler_batch_mt but only computes metrics[j] for each: no
+// Gantt segments or per-process rows are written (the jobs' logs and results are
+// ignored), and the percentile sketches keep memory independent of n. Returns the number
+// of jobs run, or -1 on invalid arguments.
+SCHEDULER_API int run_scheduler_metrics_batch(
+    const Process* procs,
+    int n,
+    const BatchJob* jobs,
+    int num_jobs,
+    SchedulerMetrics* metrics,
+    int flags,
+    int num_workers
+) {
+    if (n < 0 || num_jobs < 0 || (n > 0 && !procs) || (num_jobs > 0 && (!jobs || !metrics))) return -1;
+
+    std::vector<int> arrival_order;
+    InputView input = {procs, n, nullptr};
+    build_arrival_order(input, (flags & SCHED_FLAG_PRESORTED) != 0, arrival_order);
+    if (num_workers <= 0) num_workers = std::max(1u, std::thread::hardware_concurrency());
+    run_batch_jobs(num_jobs, num_workers, [&](int j, SimState& st) {
+        MetricsAccumulator acc; // About 20 KB of histograms, whatever n is
+        run_metrics_job(procs, n, jobs[j], arrival_order, st, acc, metrics[j]);
+    });
+    return num_jobs;
+}
+
+// Metrics of a single run over the read-only input. config may be NULL. Returns 0, or -1
+// on invalid arguments.
+SCHEDULER_API int run_scheduler_metrics(
+    const Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum,
+    const SchedulerConfig* config,
+    SchedulerMetrics* metrics,
+    int flags
+) {
+    BatchJob job = {algorithm_code, quantum, nullptr, nullptr, 0, nullptr, config};
+    return run_scheduler_metrics_batch(procs, n, &job, 1, metrics, flags, 1) == 1 ? 0 : -1;
+}
+
+// Writes workload index of spec (spec->num_processes processes) into out, exactly as
+// run_monte_carlo generates it. Returns the process count, or -1 on invalid arguments.
+SCHEDULER_API int generate_workload(const WorkloadSpec* spec, long long index, Process* out) {
+    if (!spec || spec->num_processes < 1 || !out || index < 0) return -1;
+    generate_workload_into(*spec, (uint64_t)index, out);
+    return spec->num_processes;
+}
+
+// Generates num_workloads random workloads from spec and runs every job on each of them
+// through the metrics engine, num_workers workloads at a time (<= 0: one per core).
+// summaries[j] gets job j's metric means over the workloads with a two-sided confidence
+// interval (e.g. 0.95; values outside (0, 1) mean 0.95). Jobs only use algorithm_code,
+// quantum and config: MLQ takes each process's queue from its generated priority.
+// Returns num_workloads, or -1 on invalid arguments.
+SCHEDULER_API int run_monte_carlo(
+    const WorkloadSpec* spec,
+    int num_workloads,
+    const BatchJob* jobs,
+    int num_jobs,
+    double confidence,
+    MonteCarloSummary* summaries,
+    int num_workers
+) {
+    if (!spec || spec->num_processes < 1 || num_workloads < 1 || num_jobs < 0 || (num_jobs > 0 && (!jobs || !summaries))) return -1;
+    if (!(confidence > 0 && confidence < 1)) confidence = 0.95;
+    int n = spec->num_processes;
+    bool presorted = spec->arrival_model != ARRIVAL_UNIFORM;
+
+    // values[(j * MC_METRICS + m) * num_workloads + w]
+    std::vector<double> values((size_t)num_jobs * MC_METRICS * num_workloads);
+    if (num_workers <= 0) num_workers = std::max(1u, std::thread::hardware_concurrency());
+    run_batch_jobs(num_workloads, num_workers, [&](int w, SimState& st) {
+        std::vector<Process> procs(n);
+        std::vector<int> arrival_order;
+        generate_workload_into(*spec, (uint64_t)w, procs.data());
+        InputView input = {procs.data(), n, nullptr};
+        build_arrival_order(input, presorted, arrival_order);
+        MetricsAccumulator acc;
+        for (int j = 0; j < num_jobs; j++) {
+            BatchJob job = jobs[j];
+            job.mlq_queues = nullptr;
+            SchedulerMetrics metrics;
+            run_metrics_job(procs.data(), n, job, arrival_order, st, acc, metrics);
+            double picked[MC_METRICS];
+            monte_carlo_values(metrics, picked);
+            for (int m = 0; m < MC_METRICS; m++) values[((size_t)j * MC_METRICS + m) * num_workloads + w] = picked[m];
+        }
+    });
+
+    for (int j = 0; j < num_jobs; j++) {
+        MonteCarloSummary& out = summaries[j];
+        out.workloads = num_workloads;
+        MetricInterval* fields[MC_METRICS] = {&out.avg_wt, &out.avg_tat, &out.avg_rt, &out.p99_wt, &out.p99_tat,
+                                              &out.makespan, &out.utilization, &out.throughput, &out.context_switches};
+        for (int m = 0; m < MC_METRICS; m++) {
+            *fields[m] = confidence_interval(&values[((size_t)j * MC_METRICS + m) * num_workloads], num_workloads, confidence);
+        }
+    }
+    return num_workloads;
+}
+
+// scheduler_log_bound for one batch job, honouring its MLQ queue assignment.
+SCHEDULER_API int scheduler_job_log_bound(
+    const Process* procs,
+    int n,
+    const BatchJob* job
+) {
+    if (!job) return 0;
+    InputView input = {procs, n, job->algorithm_code == 7 ? job->mlq_queues : nullptr};
+    SchedParams params(job->config);
+    return (int)std::min<long long>(INT_MAX, gantt_segment_bound(input, job->algorithm_code, job->quantum, params));
+}
+
+// Simulates the workload on smp->num_cpus CPUs (see SmpEngine) and writes the merged,
+// CPU-tagged timeline into logs, keeping the first max_logs segments. Results go back into
+// procs, with current_queue set to the CPU each process finished on. Returns the number
+// of segments stored (the exact total with logs == NULL), or -1 for an invalid SMP config
+// or for MLFQ/MLQ, which are not modelled per CPU.
+SCHEDULER_API int run_scheduler_smp(
+    Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum,
+    const SmpConfig* smp,
+    SmpGanttLog* logs,
+    int max_logs,
+    int flags
+) {
+    if (n < 0 || !smp || smp->num_cpus < 1 || algorithm_code == 6 || algorithm_code == 7) return -1;
+
+    std::vector<int> arrival_order;
+    InputView input = {procs, n, nullptr};
+    build_arrival_order(input, (flags & SCHED_FLAG_PRESORTED) != 0, arrival_order);
+    SimState st;
+    st.reset(input, algorithm_code);
+    int completed = complete_zero_bursts(st);
+
+    SmpGanttWriter writer(logs, logs ? std::max(0, max_logs) : 0, smp->num_cpus);
+    SmpEngine engine(input, algorithm_code, quantum, *smp, st, writer);
+    engine.run(arrival_order, completed);
+    write_results(input, st, procs);
+    return logs ? writer.stored() : writer.total();
+}
+
+// Simulates a binary trace file (see TraceFileHeader) and writes the merged Gantt timeline
+// to gantt_path and, unless results_path is NULL, the per-process results to
+// results_path. The pid of each trace entry is its 1-based position. config may be NULL.
+// Returns the number of segments written, -1 if the trace cannot be read or is
+// malformed, or -2 if an output file cannot be written.
+SCHEDULER_API int run_scheduler_trace(
+    const char* trace_path,
+    int algorithm_code,
+    int quantum,
+    const SchedulerConfig* config,
+    const char* gantt_path,
+    const char* results_path,
+    int flags
+) {
+    if (!trace_path || !gantt_path) return -1;
+    MappedFile trace;
+    InputView input = {nullptr, 0, nullptr};
+    std::vector<int> decoded_at;
+    bool presorted = false;
+    if (!trace.open_read(trace_path) || !bind_trace(trace, input, decoded_at, presorted)) return -1;
+    if (algorithm_code != 7) input.mlq_queues = nullptr;
+
+    std::vector<int> arrival_order;
+    build_arrival_order(input, presorted || (flags & SCHED_FLAG_PRESORTED) != 0, arrival_order);
+    SchedParams params(config);
+    long long bound = std::max(1LL, gantt_segment_bound(input, algorithm_code, quantum, params));
+    if (bound > INT_MAX) return -2;
+
+    // The Gantt file is mapped at its worst-case size and cut to the segments written
+    MappedFile gantt;
+    if (!gantt.create(gantt_path, sizeof(TraceFileHeader) + (uint64_t)bound * sizeof(GanttLog))) return -2;
+    GanttWriter writer((GanttLog*)(gantt.data() + sizeof(TraceFileHeader)), (int)bound, nullptr, nullptr);
+    SimState st;
+    simulate(input, algorithm_code, quantum, params, arrival_order, st, writer);
+
+    TraceFileHeader header;
+    init_header(header, "HOSGANTT", (uint64_t)writer.stored());
+    header.columns[0] = sizeof(header);
+    std::memcpy(gantt.data(), &header, sizeof(header));
+    if (!gantt.close(sizeof(header) + (uint64_t)writer.stored() * sizeof(GanttLog))) return -2;
+
+    if (results_path && !write_trace_results(results_path, st, input.n)) return -2;
+    return writer.stored();
+}
+
+// Opens an online session for one algorithm (config may be NULL). Returns NULL when out
+// of memory. A session is used by one thread at a time.
+SCHEDULER_API SchedulerSession* scheduler_session_create(int algorithm_code, int quantum, const SchedulerConfig* config) {
+    SchedulerSession* s = new (std::nothrow) SchedulerSession(algorithm_code, config);
+    if (!s) return nullptr;
+    s->kernel.reset(make_session_kernel(*s, quantum));
+    s->reserve(64);
+    return s;
+}
+
+// Submits a process arriving at at (for MLQ, priority is the queue id). Returns its pid,
+// the 1-based submission number, or -1 if the session is closed or already advanced past at.
+SCHEDULER_API int scheduler_session_submit(SchedulerSession* s, int at, int bt, int priority) {
+    return s ? s->submit(at, bt, priority) : -1;
+}
+
+// Schedules everything that can be decided up to t; later submissions must arrive at t
+// or after. Returns the number of segments ready to drain.
+SCHEDULER_API int scheduler_session_advance(SchedulerSession* s, int t) {
+    if (!s) return -1;
+    s->advance_to(t);
+    s->writer.flush();
+    return (int)std::min<size_t>(INT_MAX, s->segments.size());
+}
+
+// Ends the feed: runs every submitted process to completion and closes the last segment.
+SCHEDULER_API int scheduler_session_close(SchedulerSession* s) {
+    if (!s) return -1;
+    s->close();
+    return (int)std::min<size_t>(INT_MAX, s->segments.size());
+}
+
+// Moves up to max_logs finished, merged Gantt segments into logs, oldest first, and
+// returns how many were moved. The segment still being extended is only drained once it
+// closes. With logs == NULL, returns the number waiting instead.
+SCHEDULER_API int scheduler_session_drain_segments(SchedulerSession* s, GanttLog* logs, int max_logs) {
+    if (!s) return -1;
+    s->writer.flush();
+    if (!logs) return (int)std::min<size_t>(INT_MAX, s->segments.size());
+    int count = (int)std::min<size_t>(std::max(0, max_logs), s->segments.size());
+    std::copy(s->segments.begin(), s->segments.begin() + count, logs);
+    s->segments.erase(s->segments.begin(), s->segments.begin() + count);
+    return count;
+}
+
+// Moves up to max_results completed processes into results (in the run_scheduler layout),
+// in completion order, and returns how many were moved (waiting count with results == NULL).
+SCHEDULER_API int scheduler_session_drain_completions(SchedulerSession* s, Process* results, int max_results) {
+    if (!s) return -1;
+    if (!results) return (int)std::min<size_t>(INT_MAX, s->completions.size());
+    int count = (int)std::min<size_t>(std::max(0, max_results), s->completions.size());
+    for (int k = 0; k < count; k++) s->fill_result(s->completions[k], results[k]);
+    s->completions.erase(s->completions.begin(), s->completions.begin() + count);
+    return count;
+}
+
+SCHEDULER_API void scheduler_session_destroy(SchedulerSession* s) {
+    delete s;
+}
+
+// Builds the level-of-detail pyramid of a merged single-CPU timeline (as written by
+// run_scheduler and the batch runs). Returns NULL when out of memory or when the segments
+// overlap or are out of order, e.g. an SMP timeline.
+SCHEDULER_API GanttLod* gantt_lod_create(const GanttLog* logs, int count) {
+    if (!logs && count > 0) return nullptr;
+    GanttLod* lod = new (std::nothrow) GanttLod();
+    if (lod && !lod->build(logs, count)) {
+        delete lod;
+        return nullptr;
+    }
+    return lod;
+}
+
+// The view of [t0, t1) at pixels columns (see GanttLod::query). Returns -1 if lod is NULL.
+SCHEDULER_API int gantt_lod_query(const GanttLod* lod, int t0, int t1, int pixels, GanttLodSegment* out, int max_out) {
+    if (!lod || !out) return -1;
+    return lod->query(t0, t1, pixels, out, max_out);
+}
+
+SCHEDULER_API void gantt_lod_destroy(GanttLod* lod) {
+    delete lod;
+}
+
+// scheduler_smp_log_bound for a run with smp's switch and warm-up overhead (smp may be NULL).
+SCHEDULER_API int scheduler_smp_config_log_bound(
+    const Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum,
+    const SmpConfig* smp
+) {
+    return (int)std::min<long long>(INT_MAX, smp_segment_bound(procs, n, algorithm_code, quantum, smp));
+}
+
+// A logs buffer of this many segments is never truncated by run_scheduler_smp without
+// overhead (see scheduler_smp_config_log_bound).
+SCHEDULER_API int scheduler_smp_log_bound(
+    const Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum
+) {
+    return scheduler_smp_config_log_bound(procs, n, algorithm_code, quantum, nullptr);
+}
+
+SCHEDULER_API int run_scheduler(
+    Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum, 
+    GanttLog* logs,
+    int max_logs
+) {
+    return run_scheduler_ex(procs, n, algorithm_code, quantum, logs, max_logs, 0);
+}
+
+// The original tick-by-tick engine (scheduler_reference.cpp), for differential testing of
+// run_scheduler: same inputs, outputs and return value, but no config and no flags.
+// Returns -1 unless the library is built with SCHEDULER_REFERENCE, or when a bt is below
+// 1 or any pointer is NULL (the reference engine would never finish).
+SCHEDULER_API int run_scheduler_reference(
+    Process* procs,
+    int n,
+    int algorithm_code,
+    int quantum,
+    GanttLog* logs,
+    int max_logs
+) {
+#if defined(SCHEDULER_REFERENCE)
+    if (!procs || !logs || n < 0) return -1;
+    for (int i = 0; i < n; i++) {
+        if (procs[i].bt < 1) return -1;
+    }
+    return reference_run_scheduler(procs, n, algorithm_code, std::max(1, quantum), logs, max_logs);
+#else
+    (void)procs, (void)n, (void)algorithm_code, (void)quantum, (void)logs, (void)max_logs;
+    return -1;
+#endif
+}
+
+}
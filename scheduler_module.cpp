@@ -0,0 +1,281 @@
+// CPython extension module "_scheduler": the scheduler engine callable from Python without
+// ctypes. Arguments are buffer-protocol objects (NumPy arrays with the PROCESS_DTYPE /
+// GANTT_DTYPE layouts from scheduler_wrapper.py) and every simulation runs with the GIL
+// released, so concurrent sessions and Python threads run in parallel.
+// Build with: python setup.py build_ext --inplace
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <deque>
+
+#include "scheduler.cpp" // Built as one translation unit with the engine
+
+// Holds a C-contiguous buffer for the lifetime of a call.
+struct BufferArg {
+    Py_buffer view;
+    bool held = false;
+
+    BufferArg() = default;
+    BufferArg(const BufferArg&) = delete;
+    BufferArg& operator=(const BufferArg&) = delete;
+    ~BufferArg() { if (held) PyBuffer_Release(&view); }
+
+    // Returns false (with a Python exception set) if obj is not a buffer of whole items.
+    bool acquire(PyObject* obj, size_t item_size, bool writable, const char* what) {
+        int flags = PyBUF_C_CONTIGUOUS | (writable ? PyBUF_WRITABLE : 0);
+        if (PyObject_GetBuffer(obj, &view, flags) != 0) return false;
+        held = true;
+        if (view.len % (Py_ssize_t)item_size != 0 || view.len / (Py_ssize_t)item_size > INT_MAX) {
+            PyErr_Format(PyExc_ValueError, "%s: buffer size is not a whole number of %zu-byte records",
+                         what, item_size);
+            return false;
+        }
+        return true;
+    }
+
+    int count(size_t item_size) const { return (int)(view.len / (Py_ssize_t)item_size); }
+    template <typename T> T* data() const { return static_cast<T*>(view.buf); }
+};
+
+// Parses the scheduler_wrapper config dict (aging_rate, mlfq_quanta, promotion_threshold,
+// mlq_q2_quantum, switch_cost, resume_penalty; missing keys keep the defaults). None or an
+// empty dict give no config.
+struct ConfigArg {
+    SchedulerConfig config = {};
+    std::vector<int> quanta;
+    bool present = false;
+
+    const SchedulerConfig* get() const { return present ? &config : nullptr; }
+
+    bool parse(PyObject* obj) {
+        if (!obj || obj == Py_None) return true;
+        if (!PyDict_Check(obj)) {
+            PyErr_SetString(PyExc_TypeError, "config must be a dict or None");
+            return false;
+        }
+        if (PyDict_Size(obj) == 0) return true;
+        present = true;
+        if (!int_field(obj, "aging_rate", config.aging_rate)) return false;
+        if (!int_field(obj, "promotion_threshold", config.promotion_threshold)) return false;
+        if (!int_field(obj, "mlq_q2_quantum", config.mlq_q2_quantum)) return false;
+        if (!int_field(obj, "switch_cost", config.switch_cost)) return false;
+        if (!int_field(obj, "resume_penalty", config.resume_penalty)) return false;
+
+        PyObject* levels = PyDict_GetItemString(obj, "mlfq_quanta");
+        if (levels && levels != Py_None) {
+            PyObject* seq = PySequence_Fast(levels, "mlfq_quanta must be a sequence");
+            if (!seq) return false;
+            Py_ssize_t count = PySequence_Fast_GET_SIZE(seq);
+            for (Py_ssize_t i = 0; i < count; i++) {
+                long q = PyLong_AsLong(PySequence_Fast_GET_ITEM(seq, i));
+                if (q == -1 && PyErr_Occurred()) { Py_DECREF(seq); return false; }
+                quanta.push_back((int)q);
+            }
+            Py_DECREF(seq);
+            // The quanta cover the RR levels above the final FCFS level
+            config.mlfq_levels = (int)quanta.size() + 1;
+            config.mlfq_quanta = quanta.empty() ? nullptr : quanta.data();
+        }
+        return true;
+    }
+
+private:
+    static bool int_field(PyObject* dict, const char* key, int& out) {
+        PyObject* value = PyDict_GetItemString(dict, key);
+        if (!value || value == Py_None) return true;
+        long v = PyLong_AsLong(value);
+        if (v == -1 && PyErr_Occurred()) return false;
+        out = (int)v;
+        return true;
+    }
+};
+
+// One parsed batch job dict: algorithm_code, quantum, logs, results and optionally
+// mlq_queues and config. logs may be None to only count segments.
+struct JobArg {
+    BatchJob job = {};
+    BufferArg logs, results, queues;
+    ConfigArg config;
+
+    bool parse(PyObject* obj, int n, bool need_outputs) {
+        if (!PyDict_Check(obj)) {
+            PyErr_SetString(PyExc_TypeError, "each job must be a dict");
+            return false;
+        }
+        PyObject* code = PyDict_GetItemString(obj, "algorithm_code");
+        PyObject* quantum = PyDict_GetItemString(obj, "quantum");
+        if (!code) {
+            PyErr_SetString(PyExc_KeyError, "job is missing algorithm_code");
+            return false;
+        }
+        job.algorithm_code = (int)PyLong_AsLong(code);
+        job.quantum = quantum ? (int)PyLong_AsLong(quantum) : 2;
+        if (PyErr_Occurred()) return false;
+
+        if (!config.parse(PyDict_GetItemString(obj, "config"))) return false;
+        job.config = config.get();
+
+        PyObject* mlq = PyDict_GetItemString(obj, "mlq_queues");
+        if (mlq && mlq != Py_None) {
+            if (!queues.acquire(mlq, sizeof(int), false, "mlq_queues")) return false;
+            if (queues.count(sizeof(int)) != n) {
+                PyErr_SetString(PyExc_ValueError, "mlq_queues must hold one queue per process");
+                return false;
+            }
+            job.mlq_queues = queues.data<int>();
+        }
+
+        if (!need_outputs) return true;
+        PyObject* out = PyDict_GetItemString(obj, "results");
+        PyObject* gantt = PyDict_GetItemString(obj, "logs");
+        if (!out || !gantt) {
+            PyErr_SetString(PyExc_KeyError, "job needs results and logs buffers");
+            return false;
+        }
+        if (!results.acquire(out, sizeof(Process), true, "results")) return false;
+        if (results.count(sizeof(Process)) < n) {
+            PyErr_SetString(PyExc_ValueError, "results must hold one record per process");
+            return false;
+        }
+        job.results = results.data<Process>();
+        if (gantt != Py_None) {
+            if (!logs.acquire(gantt, sizeof(GanttLog), true, "logs")) return false;
+            job.logs = logs.data<GanttLog>();
+            job.max_logs = logs.count(sizeof(GanttLog));
+        }
+        return true;
+    }
+};
+
+// run_scheduler(procs, algorithm_code, quantum, logs, config=None, flags=0) -> int
+// Simulates in place on procs and fills logs; see run_scheduler_config.
+static PyObject* py_run_scheduler(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"procs", "algorithm_code", "quantum", "logs", "config", "flags", nullptr};
+    PyObject *procs_obj, *logs_obj, *config_obj = Py_None;
+    int code, quantum, flags = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OiiO|Oi", const_cast<char**>(keywords),
+                                     &procs_obj, &code, &quantum, &logs_obj, &config_obj, &flags))
+        return nullptr;
+
+    BufferArg procs, logs;
+    ConfigArg config;
+    if (!procs.acquire(procs_obj, sizeof(Process), true, "procs")) return nullptr;
+    if (logs_obj != Py_None && !logs.acquire(logs_obj, sizeof(GanttLog), true, "logs")) return nullptr;
+    if (!config.parse(config_obj)) return nullptr;
+
+    int n = procs.count(sizeof(Process));
+    GanttLog* log_data = logs.held ? logs.data<GanttLog>() : nullptr;
+    int max_logs = logs.held ? logs.count(sizeof(GanttLog)) : 0;
+    int stored;
+    Py_BEGIN_ALLOW_THREADS
+    stored = run_scheduler_config(procs.data<Process>(), n, code, quantum, config.get(), log_data, max_logs, flags);
+    Py_END_ALLOW_THREADS
+    return PyLong_FromLong(stored);
+}
+
+// log_bound(procs, algorithm_code, quantum, config=None) -> int
+static PyObject* py_log_bound(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"procs", "algorithm_code", "quantum", "config", nullptr};
+    PyObject *procs_obj, *config_obj = Py_None;
+    int code, quantum;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "Oii|O", const_cast<char**>(keywords),
+                                     &procs_obj, &code, &quantum, &config_obj))
+        return nullptr;
+
+    BufferArg procs;
+    ConfigArg config;
+    if (!procs.acquire(procs_obj, sizeof(Process), false, "procs")) return nullptr;
+    if (!config.parse(config_obj)) return nullptr;
+    return PyLong_FromLong(scheduler_config_log_bound(procs.data<Process>(), procs.count(sizeof(Process)),
+                                                      code, quantum, config.get()));
+}
+
+// job_log_bound(procs, job) -> int, honouring the job's MLQ queues and config.
+static PyObject* py_job_log_bound(PyObject*, PyObject* args) {
+    PyObject *procs_obj, *job_obj;
+    if (!PyArg_ParseTuple(args, "OO", &procs_obj, &job_obj)) return nullptr;
+
+    BufferArg procs;
+    if (!procs.acquire(procs_obj, sizeof(Process), false, "procs")) return nullptr;
+    int n = procs.count(sizeof(Process));
+    JobArg job;
+    if (!job.parse(job_obj, n, false)) return nullptr;
+    return PyLong_FromLong(scheduler_job_log_bound(procs.data<Process>(), n, &job.job));
+}
+
+// run_batch(procs, jobs, workers=0, flags=0) -> list of metrics dicts, one per job.
+// Every job reads procs in place and writes its own results and logs buffers.
+static PyObject* py_run_batch(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"procs", "jobs", "workers", "flags", nullptr};
+    PyObject *procs_obj, *jobs_obj;
+    int workers = 0, flags = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|ii", const_cast<char**>(keywords),
+                                     &procs_obj, &jobs_obj, &workers, &flags))
+        return nullptr;
+
+    BufferArg procs;
+    if (!procs.acquire(procs_obj, sizeof(Process), false, "procs")) return nullptr;
+    int n = procs.count(sizeof(Process));
+
+    PyObject* seq = PySequence_Fast(jobs_obj, "jobs must be a sequence");
+    if (!seq) return nullptr;
+    std::deque<JobArg> parsed; // Stable addresses: each JobArg owns its buffers
+    std::vector<BatchJob> jobs;
+    Py_ssize_t num_jobs = PySequence_Fast_GET_SIZE(seq);
+    for (Py_ssize_t j = 0; j < num_jobs; j++) {
+        parsed.emplace_back();
+        if (!parsed.back().parse(PySequence_Fast_GET_ITEM(seq, j), n, true)) {
+            Py_DECREF(seq);
+            return nullptr;
+        }
+        jobs.push_back(parsed.back().job);
+    }
+    Py_DECREF(seq);
+
+    std::vector<BatchResult> results(jobs.size());
+    int ran;
+    Py_BEGIN_ALLOW_THREADS
+    ran = run_scheduler_batch_mt(procs.data<Process>(), n, jobs.data(), (int)jobs.size(), results.data(),
+                                 flags, workers);
+    Py_END_ALLOW_THREADS
+    if (ran < 0) {
+        PyErr_SetString(PyExc_ValueError, "invalid batch arguments");
+        return nullptr;
+    }
+
+    PyObject* out = PyList_New((Py_ssize_t)results.size());
+    if (!out) return nullptr;
+    for (size_t j = 0; j < results.size(); j++) {
+        const BatchResult& r = results[j];
+        PyObject* metrics = Py_BuildValue(
+            "{s:i,s:i,s:i,s:i,s:d,s:d,s:d,s:i,s:i}",
+            "segments", r.segments, "makespan", r.makespan, "idle_time", r.idle_time,
+            "context_switches", r.context_switches, "avg_tat", r.avg_tat, "avg_wt", r.avg_wt,
+            "avg_rt", r.avg_rt, "switch_time", r.switch_time, "warmup_time", r.warmup_time);
+        if (!metrics) { Py_DECREF(out); return nullptr; }
+        PyList_SET_ITEM(out, (Py_ssize_t)j, metrics);
+    }
+    return out;
+}
+
+static PyMethodDef scheduler_methods[] = {
+    {"run_scheduler", (PyCFunction)(void (*)(void))py_run_scheduler, METH_VARARGS | METH_KEYWORDS,
+     "run_scheduler(procs, algorithm_code, quantum, logs, config=None, flags=0) -> segments stored"},
+    {"log_bound", (PyCFunction)(void (*)(void))py_log_bound, METH_VARARGS | METH_KEYWORDS,
+     "log_bound(procs, algorithm_code, quantum, config=None) -> Gantt buffer size that is never truncated"},
+    {"job_log_bound", py_job_log_bound, METH_VARARGS,
+     "job_log_bound(procs, job) -> log_bound for one batch job dict"},
+    {"run_batch", (PyCFunction)(void (*)(void))py_run_batch, METH_VARARGS | METH_KEYWORDS,
+     "run_batch(procs, jobs, workers=0, flags=0) -> list of metrics dicts"},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+static PyModuleDef scheduler_module = {
+    PyModuleDef_HEAD_INIT, "_scheduler",
+    "Native bindings for the scheduler engine; simulations run with the GIL released.",
+    -1, scheduler_methods, nullptr, nullptr, nullptr, nullptr
+};
+
+PyMODINIT_FUNC PyInit__scheduler(void) {
+    return PyModule_Create(&scheduler_module);
+}
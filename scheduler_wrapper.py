@@ -1,6 +1,13 @@
 import ctypes
+import struct
+import numpy as np
 import pandas as pd
 import os
+import sys
+import hashlib
+import json
+import threading
+from collections import OrderedDict
 import streamlit as st # Retained for exception definition, must not be used directly
 
 # --- Error Handling Setup ---
@@ -8,9 +15,9 @@ class SchedulerLoadError(Exception):
     """Custom exception raised when the DLL fails to load."""
     pass
 
-def run_scheduler_dummy(procs, n, algorithm_code, quantum, logs, max_logs):
+def run_scheduler_dummy(*args):
     """Dummy function to raise a clear error if the DLL is not loaded."""
-    raise SchedulerLoadError("The C++ scheduler.dll could not be loaded. Please ensure the file is in the project directory and compiled correctly.")
+    raise SchedulerLoadError(load_error or f"The C++ scheduler library ({LIB_NAME}) could not be loaded. Please ensure the file is in the project directory and compiled correctly.")
 
 # 1. Define C Structures
 class Process(ctypes.Structure):
@@ -37,20 +44,236 @@ class GanttLog(ctypes.Structure):
         ("finish", ctypes.c_int),
     ]
 
+class SmpGanttLog(ctypes.Structure):
+    _fields_ = [
+        ("cpu", ctypes.c_int),
+        ("pid", ctypes.c_int),
+        ("start", ctypes.c_int),
+        ("finish", ctypes.c_int),
+    ]
+
+class GanttLodSegment(ctypes.Structure):
+    _fields_ = [
+        ("pid", ctypes.c_int),
+        ("start", ctypes.c_int),
+        ("finish", ctypes.c_int),
+        ("busy", ctypes.c_int),
+    ]
+
+class SmpConfig(ctypes.Structure):
+    _fields_ = [
+        ("num_cpus", ctypes.c_int),
+        ("balance", ctypes.c_int),
+        ("affinity", ctypes.POINTER(ctypes.c_int)),
+        ("switch_cost", ctypes.c_int),
+        ("resume_penalty", ctypes.c_int),
+        ("migration_penalty", ctypes.c_int),
+    ]
+
+class SchedulerConfig(ctypes.Structure):
+    _fields_ = [
+        ("aging_rate", ctypes.c_int),
+        ("mlfq_levels", ctypes.c_int),
+        ("mlfq_quanta", ctypes.POINTER(ctypes.c_int)),
+        ("promotion_threshold", ctypes.c_int),
+        ("mlq_q2_quantum", ctypes.c_int),
+        ("switch_cost", ctypes.c_int),
+        ("resume_penalty", ctypes.c_int),
+    ]
+
+class IoPlan(ctypes.Structure):
+    _fields_ = [
+        ("offsets", ctypes.POINTER(ctypes.c_int)),
+        ("bursts", ctypes.POINTER(ctypes.c_int)),
+        ("devices", ctypes.POINTER(ctypes.c_int)),
+        ("num_devices", ctypes.c_int),
+    ]
+
+class BatchJob(ctypes.Structure):
+    _fields_ = [
+        ("algorithm_code", ctypes.c_int),
+        ("quantum", ctypes.c_int),
+        ("mlq_queues", ctypes.POINTER(ctypes.c_int)),
+        ("logs", ctypes.POINTER(GanttLog)),
+        ("max_logs", ctypes.c_int),
+        ("results", ctypes.POINTER(Process)),
+        ("config", ctypes.POINTER(SchedulerConfig)),
+    ]
+
+class BatchResult(ctypes.Structure):
+    _fields_ = [
+        ("segments", ctypes.c_int),
+        ("makespan", ctypes.c_int),
+        ("idle_time", ctypes.c_int),
+        ("context_switches", ctypes.c_int),
+        ("avg_tat", ctypes.c_double),
+        ("avg_wt", ctypes.c_double),
+        ("avg_rt", ctypes.c_double),
+        ("switch_time", ctypes.c_int),
+        ("warmup_time", ctypes.c_int),
+    ]
+
+class MetricSummary(ctypes.Structure):
+    _fields_ = [
+        ("mean", ctypes.c_double),
+        ("p50", ctypes.c_double),
+        ("p95", ctypes.c_double),
+        ("p99", ctypes.c_double),
+        ("max", ctypes.c_double),
+    ]
+
+class SchedulerMetrics(ctypes.Structure):
+    _fields_ = [
+        ("processes", ctypes.c_int),
+        ("segments", ctypes.c_int),
+        ("makespan", ctypes.c_int),
+        ("idle_time", ctypes.c_int),
+        ("context_switches", ctypes.c_int),
+        ("switch_time", ctypes.c_int),
+        ("warmup_time", ctypes.c_int),
+        ("utilization", ctypes.c_double),
+        ("throughput", ctypes.c_double),
+        ("wt", MetricSummary),
+        ("tat", MetricSummary),
+        ("rt", MetricSummary),
+    ]
+
+class WorkloadSpec(ctypes.Structure):
+    _fields_ = [
+        ("num_processes", ctypes.c_int),
+        ("arrival_model", ctypes.c_int),
+        ("arrival_rate", ctypes.c_double),
+        ("burstiness", ctypes.c_double),
+        ("burst_model", ctypes.c_int),
+        ("burst_mean", ctypes.c_double),
+        ("burst_shape", ctypes.c_double),
+        ("max_burst", ctypes.c_int),
+        ("max_priority", ctypes.c_int),
+        ("seed", ctypes.c_ulonglong),
+    ]
+
+class MetricInterval(ctypes.Structure):
+    _fields_ = [
+        ("mean", ctypes.c_double),
+        ("stddev", ctypes.c_double),
+        ("low", ctypes.c_double),
+        ("high", ctypes.c_double),
+    ]
+
+class MonteCarloSummary(ctypes.Structure):
+    _fields_ = [("workloads", ctypes.c_int)] + [
+        (name, MetricInterval) for name in (
+            "avg_wt", "avg_tat", "avg_rt", "p99_wt", "p99_tat", "makespan", "utilization", "throughput",
+            "context_switches",
+        )
+    ]
+
+# Engine phases timed by run_scheduler_profiled, in SCHED_PHASE_* order
+PROFILE_PHASES = ("arrival_sort", "arrivals", "select", "preempt_check", "aging", "gantt_merge", "results")
+
+class SchedulerProfile(ctypes.Structure):
+    _fields_ = [
+        ("enabled", ctypes.c_int),
+        ("clock", ctypes.c_int),
+        ("tick_ns", ctypes.c_double),
+        ("total_ticks", ctypes.c_ulonglong),
+        ("ticks", ctypes.c_ulonglong * len(PROFILE_PHASES)),
+        ("calls", ctypes.c_ulonglong * len(PROFILE_PHASES)),
+        ("arrivals", ctypes.c_longlong),
+        ("dispatches", ctypes.c_longlong),
+        ("preemptions", ctypes.c_longlong),
+        ("completions", ctypes.c_longlong),
+        ("idle_gaps", ctypes.c_longlong),
+        ("aging_steps", ctypes.c_longlong),
+        ("segments", ctypes.c_longlong),
+        ("max_ready", ctypes.c_int),
+        ("trace_events", ctypes.c_int),
+        ("trace_dropped", ctypes.c_int),
+    ]
+
+# NumPy layouts matching the C structs, so arrays go to the DLL without copying
+PROCESS_DTYPE = np.dtype([(name, np.int32) for name, _ in Process._fields_])
+GANTT_DTYPE = np.dtype([(name, np.int32) for name, _ in GanttLog._fields_])
+SMP_GANTT_DTYPE = np.dtype([(name, np.int32) for name, _ in SmpGanttLog._fields_])
+GANTT_LOD_DTYPE = np.dtype([(name, np.int32) for name, _ in GanttLodSegment._fields_])
+
+# Callback receiving each filled chunk of merged Gantt segments from run_scheduler_stream
+GanttSink = ctypes.CFUNCTYPE(None, ctypes.POINTER(GanttLog), ctypes.c_int, ctypes.c_void_p)
+
 # 2. Load Library
-dll_path = os.path.abspath("scheduler.dll")
+# Platform-specific name of the shared library built by CMakeLists.txt
+LIB_NAME = {"win32": "scheduler.dll", "cygwin": "scheduler.dll", "darwin": "scheduler.dylib"}.get(sys.platform, "scheduler.so")
+
+def _find_library():
+    """SCHEDULER_LIB overrides; otherwise the library next to this file, then the working directory."""
+    override = os.environ.get("SCHEDULER_LIB")
+    if override:
+        return os.path.abspath(override)
+    for folder in (os.path.dirname(os.path.abspath(__file__)), os.getcwd()):
+        candidate = os.path.join(folder, LIB_NAME)
+        if os.path.exists(candidate):
+            return candidate
+    return os.path.abspath(LIB_NAME)
+
+dll_path = _find_library()
 lib = None
 dll_loaded = False
+load_error = None # Set when the library loads but is out of date
+
+# Every export the wrapper binds; an older library missing any of them is not used
+class DummyLib:
+    run_scheduler = staticmethod(run_scheduler_dummy)
+    run_scheduler_ex = staticmethod(run_scheduler_dummy)
+    run_scheduler_stream = staticmethod(run_scheduler_dummy)
+    scheduler_log_bound = staticmethod(run_scheduler_dummy)
+    run_scheduler_batch = staticmethod(run_scheduler_dummy)
+    run_scheduler_batch_mt = staticmethod(run_scheduler_dummy)
+    scheduler_job_log_bound = staticmethod(run_scheduler_dummy)
+    run_scheduler_config = staticmethod(run_scheduler_dummy)
+    scheduler_config_log_bound = staticmethod(run_scheduler_dummy)
+    run_scheduler_smp = staticmethod(run_scheduler_dummy)
+    scheduler_smp_log_bound = staticmethod(run_scheduler_dummy)
+    scheduler_smp_config_log_bound = staticmethod(run_scheduler_dummy)
+    scheduler_context_create = staticmethod(run_scheduler_dummy)
+    scheduler_context_reset = staticmethod(run_scheduler_dummy)
+    scheduler_context_destroy = staticmethod(run_scheduler_dummy)
+    run_scheduler_context = staticmethod(run_scheduler_dummy)
+    run_scheduler_trace = staticmethod(run_scheduler_dummy)
+    run_scheduler_metrics = staticmethod(run_scheduler_dummy)
+    run_scheduler_metrics_batch = staticmethod(run_scheduler_dummy)
+    run_scheduler_profiled = staticmethod(run_scheduler_dummy)
+    run_scheduler_io = staticmethod(run_scheduler_dummy)
+    generate_workload = staticmethod(run_scheduler_dummy)
+    run_monte_carlo = staticmethod(run_scheduler_dummy)
+    scheduler_io_log_bound = staticmethod(run_scheduler_dummy)
+    scheduler_session_create = staticmethod(run_scheduler_dummy)
+    scheduler_session_submit = staticmethod(run_scheduler_dummy)
+    scheduler_session_advance = staticmethod(run_scheduler_dummy)
+    scheduler_session_close = staticmethod(run_scheduler_dummy)
+    scheduler_session_drain_segments = staticmethod(run_scheduler_dummy)
+    scheduler_session_drain_completions = staticmethod(run_scheduler_dummy)
+    scheduler_session_destroy = staticmethod(run_scheduler_dummy)
+    gantt_lod_create = staticmethod(run_scheduler_dummy)
+    gantt_lod_query = staticmethod(run_scheduler_dummy)
+    gantt_lod_destroy = staticmethod(run_scheduler_dummy)
 
 try:
     lib = ctypes.CDLL(dll_path)
     dll_loaded = True
 except Exception as e:
-    print(f"Error loading scheduler.dll: {e}. Using dummy scheduler.")
-    class DummyLib:
-        run_scheduler = run_scheduler_dummy
+    print(f"Error loading {LIB_NAME}: {e}. Using dummy scheduler.")
     lib = DummyLib()
 
+if dll_loaded:
+    # A stale binary loads fine but lacks newer exports; fall back instead of failing at import
+    missing = [name for name in vars(DummyLib) if not name.startswith('_') and not hasattr(lib, name)]
+    if missing:
+        load_error = (f"The C++ scheduler library ({dll_path}) is out of date: it lacks {', '.join(missing)}. "
+                      "Rebuild it with CMake (see README) and restart the app.")
+        print(f"{load_error} Using dummy scheduler.")
+        lib = DummyLib()
+        dll_loaded = False
+
 # 3. Define function signature
 if dll_loaded:
     lib.run_scheduler.argtypes = [
@@ -58,112 +281,1035 @@ if dll_loaded:
     ]
     lib.run_scheduler.restype = ctypes.c_int
 
+    lib.run_scheduler_ex.argtypes = [
+        ctypes.POINTER(Process), ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(GanttLog), ctypes.c_int, ctypes.c_int
+    ]
+    lib.run_scheduler_ex.restype = ctypes.c_int
 
-def solve_scheduling(processes_input, algorithm_name, quantum=2, mlq_assignments=None):
-    n = len(processes_input)
+    lib.scheduler_log_bound.argtypes = [ctypes.POINTER(Process), ctypes.c_int, ctypes.c_int, ctypes.c_int]
+    lib.scheduler_log_bound.restype = ctypes.c_int
 
-    if n == 0:
-        return pd.DataFrame(), []
-    
-    ProcessArray = Process * n
-    c_procs = ProcessArray()
+    lib.run_scheduler_config.argtypes = [
+        ctypes.POINTER(Process), ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(SchedulerConfig),
+        ctypes.POINTER(GanttLog), ctypes.c_int, ctypes.c_int
+    ]
+    lib.run_scheduler_config.restype = ctypes.c_int
+
+    lib.scheduler_config_log_bound.argtypes = [
+        ctypes.POINTER(Process), ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(SchedulerConfig)
+    ]
+    lib.scheduler_config_log_bound.restype = ctypes.c_int
+
+    # CPU/I/O burst sequences
+    lib.run_scheduler_io.argtypes = [
+        ctypes.POINTER(Process), ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(SchedulerConfig),
+        ctypes.POINTER(IoPlan), ctypes.POINTER(GanttLog), ctypes.c_int, ctypes.c_int
+    ]
+    lib.run_scheduler_io.restype = ctypes.c_int
+
+    lib.scheduler_io_log_bound.argtypes = [
+        ctypes.POINTER(Process), ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(SchedulerConfig),
+        ctypes.POINTER(IoPlan)
+    ]
+    lib.scheduler_io_log_bound.restype = ctypes.c_int
+
+    lib.run_scheduler_smp.argtypes = [
+        ctypes.POINTER(Process), ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(SmpConfig),
+        ctypes.POINTER(SmpGanttLog), ctypes.c_int, ctypes.c_int
+    ]
+    lib.run_scheduler_smp.restype = ctypes.c_int
+
+    # Reusable contexts: create once, run many times without reallocating, destroy when done
+    lib.scheduler_context_create.argtypes = []
+    lib.scheduler_context_create.restype = ctypes.c_void_p
+
+    lib.scheduler_context_reset.argtypes = [ctypes.c_void_p]
+    lib.scheduler_context_reset.restype = None
+
+    lib.scheduler_context_destroy.argtypes = [ctypes.c_void_p]
+    lib.scheduler_context_destroy.restype = None
+
+    lib.run_scheduler_context.argtypes = [
+        ctypes.c_void_p, ctypes.POINTER(Process), ctypes.c_int, ctypes.c_int, ctypes.c_int,
+        ctypes.POINTER(SchedulerConfig), ctypes.POINTER(GanttLog), ctypes.c_int, ctypes.c_int
+    ]
+    lib.run_scheduler_context.restype = ctypes.c_int
+
+    lib.run_scheduler_trace.argtypes = [
+        ctypes.c_char_p, ctypes.c_int, ctypes.c_int, ctypes.POINTER(SchedulerConfig),
+        ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int
+    ]
+    lib.run_scheduler_trace.restype = ctypes.c_int
+
+    # Online sessions: submit processes as they arrive, advance the clock, drain the output
+    lib.scheduler_session_create.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.POINTER(SchedulerConfig)]
+    lib.scheduler_session_create.restype = ctypes.c_void_p
+
+    lib.scheduler_session_submit.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_int]
+    lib.scheduler_session_submit.restype = ctypes.c_int
+
+    lib.scheduler_session_advance.argtypes = [ctypes.c_void_p, ctypes.c_int]
+    lib.scheduler_session_advance.restype = ctypes.c_int
+
+    lib.scheduler_session_close.argtypes = [ctypes.c_void_p]
+    lib.scheduler_session_close.restype = ctypes.c_int
+
+    lib.scheduler_session_drain_segments.argtypes = [ctypes.c_void_p, ctypes.POINTER(GanttLog), ctypes.c_int]
+    lib.scheduler_session_drain_segments.restype = ctypes.c_int
+
+    lib.scheduler_session_drain_completions.argtypes = [ctypes.c_void_p, ctypes.POINTER(Process), ctypes.c_int]
+    lib.scheduler_session_drain_completions.restype = ctypes.c_int
+
+    lib.scheduler_session_destroy.argtypes = [ctypes.c_void_p]
+    lib.scheduler_session_destroy.restype = None
+
+    # Gantt levels of detail
+    lib.gantt_lod_create.argtypes = [ctypes.POINTER(GanttLog), ctypes.c_int]
+    lib.gantt_lod_create.restype = ctypes.c_void_p
+
+    lib.gantt_lod_query.argtypes = [
+        ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(GanttLodSegment), ctypes.c_int
+    ]
+    lib.gantt_lod_query.restype = ctypes.c_int
+
+    lib.gantt_lod_destroy.argtypes = [ctypes.c_void_p]
+    lib.gantt_lod_destroy.restype = None
+
+    lib.scheduler_smp_log_bound.argtypes = [ctypes.POINTER(Process), ctypes.c_int, ctypes.c_int, ctypes.c_int]
+    lib.scheduler_smp_log_bound.restype = ctypes.c_int
+
+    lib.scheduler_smp_config_log_bound.argtypes = [
+        ctypes.POINTER(Process), ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(SmpConfig)
+    ]
+    lib.scheduler_smp_config_log_bound.restype = ctypes.c_int
+
+    lib.run_scheduler_stream.argtypes = [
+        ctypes.POINTER(Process), ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int,
+        ctypes.POINTER(GanttLog), ctypes.c_int, GanttSink, ctypes.c_void_p, ctypes.POINTER(SchedulerConfig)
+    ]
+    lib.run_scheduler_stream.restype = ctypes.c_int
+
+    lib.run_scheduler_batch.argtypes = [
+        ctypes.POINTER(Process), ctypes.c_int, ctypes.POINTER(BatchJob), ctypes.c_int,
+        ctypes.POINTER(BatchResult), ctypes.c_int
+    ]
+    lib.run_scheduler_batch.restype = ctypes.c_int
+
+    lib.run_scheduler_batch_mt.argtypes = [
+        ctypes.POINTER(Process), ctypes.c_int, ctypes.POINTER(BatchJob), ctypes.c_int,
+        ctypes.POINTER(BatchResult), ctypes.c_int, ctypes.c_int
+    ]
+    lib.run_scheduler_batch_mt.restype = ctypes.c_int
+
+    # Metrics-only runs: summary statistics without any Gantt or per-process output
+    lib.run_scheduler_metrics.argtypes = [
+        ctypes.POINTER(Process), ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(SchedulerConfig),
+        ctypes.POINTER(SchedulerMetrics), ctypes.c_int
+    ]
+    lib.run_scheduler_metrics.restype = ctypes.c_int
+
+    lib.run_scheduler_metrics_batch.argtypes = [
+        ctypes.POINTER(Process), ctypes.c_int, ctypes.POINTER(BatchJob), ctypes.c_int,
+        ctypes.POINTER(SchedulerMetrics), ctypes.c_int, ctypes.c_int
+    ]
+    lib.run_scheduler_metrics_batch.restype = ctypes.c_int
+
+    # Profiled runs: per-phase timings and event counts (library built with SCHEDULER_INSTRUMENT)
+    lib.run_scheduler_profiled.argtypes = [
+        ctypes.POINTER(Process), ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(SchedulerConfig),
+        ctypes.POINTER(GanttLog), ctypes.c_int, ctypes.c_int, ctypes.POINTER(SchedulerProfile), ctypes.c_char_p
+    ]
+    lib.run_scheduler_profiled.restype = ctypes.c_int
+
+    # Monte Carlo sweeps over natively generated workloads
+    lib.generate_workload.argtypes = [ctypes.POINTER(WorkloadSpec), ctypes.c_longlong, ctypes.POINTER(Process)]
+    lib.generate_workload.restype = ctypes.c_int
+
+    lib.run_monte_carlo.argtypes = [
+        ctypes.POINTER(WorkloadSpec), ctypes.c_int, ctypes.POINTER(BatchJob), ctypes.c_int, ctypes.c_double,
+        ctypes.POINTER(MonteCarloSummary), ctypes.c_int
+    ]
+    lib.run_monte_carlo.restype = ctypes.c_int
+
+    lib.scheduler_job_log_bound.argtypes = [ctypes.POINTER(Process), ctypes.c_int, ctypes.POINTER(BatchJob)]
+    lib.scheduler_job_log_bound.restype = ctypes.c_int
+
+
+# Native extension module (see setup.py). When built, batch runs go through it instead of
+# ctypes and simulate with the GIL released.
+try:
+    import _scheduler as native
+except ImportError:
+    native = None
+
+
+# Timeline names of the non-process Gantt pids (GANTT_PID_* in scheduler.cpp)
+OVERHEAD_TASKS = {-1: "Idle", -2: "Switch", -3: "Warmup", -4: "Migration"}
+
+# Load balancing modes for solve_scheduling_smp
+SMP_BALANCE_MAP = {"static": 0, "push": 1, "steal": 2}
+
+# 0: FCFS, 1: SJF, 2: SRTF, 3: Prio-NP, 4: Prio-P, 5: RR, 6: MLFQ, 7: MLQ
+ALGO_MAP = {
+    "FCFS": 0, "SJF (Non-Preemptive)": 1, "SRTF (Preemptive SJF)": 2, 
+    "Priority (Non-Preemptive)": 3, "Priority (Preemptive)": 4, 
+    "Round Robin": 5, "MLFQ (Multi-Level Feedback Queue)": 6,
+    "MLQ (Multi-Level Queue)": 7 
+}
+
+
+def make_process_array(pid, at, bt, priority):
+    """Builds a PROCESS_DTYPE array from column arrays, with no per-row Python work."""
+    at = np.asarray(at, dtype=np.int32)
+    procs = np.zeros(len(at), dtype=PROCESS_DTYPE)
+    procs['pid'] = pid
+    procs['at'] = at
+    procs['bt'] = bt
+    procs['rem_time'] = bt
+    procs['priority'] = priority
+    procs['base_priority'] = priority
     
-    # 0: FCFS, 1: SJF, 2: SRTF, 3: Prio-NP, 4: Prio-P, 5: RR, 6: MLFQ, 7: MLQ
-    algo_map = {
-        "FCFS": 0, "SJF (Non-Preemptive)": 1, "SRTF (Preemptive SJF)": 2, 
-        "Priority (Non-Preemptive)": 3, "Priority (Preemptive)": 4, 
-        "Round Robin": 5, "MLFQ (Multi-Level Feedback Queue)": 6,
-        "MLQ (Multi-Level Queue)": 7 
+    # Initialize extended fields
+    procs['current_priority'] = priority # Initial current priority
+    procs['first_run'] = -1
+    procs['current_queue'] = -1
+    procs['last_q3_entry'] = -1
+    return procs
+
+
+def _process_array(processes):
+    """Converts the Python process dicts into a PROCESS_DTYPE array, one column at a time."""
+    df = pd.DataFrame(list(processes))
+    # "P12" -> 12; anything unparsable falls back to its 1-based position
+    pid_num = pd.to_numeric(df['pid'].astype(str).str.replace('P', '', regex=False), errors='coerce')
+    pid_num = pid_num.where(pid_num % 1 == 0).fillna(pd.Series(np.arange(1, len(df) + 1), index=df.index))
+    procs = make_process_array(
+        pid_num.to_numpy(dtype=np.int64),
+        df['at'].astype(np.int64).to_numpy(),
+        df['bt'].astype(np.int64).to_numpy(),
+        df['priority'].astype(np.int64).to_numpy(),
+    )
+    return procs, df
+
+
+def _to_c_config(config):
+    """
+    Builds a SchedulerConfig from a dict with any of: aging_rate, mlfq_quanta (RR quanta of
+    the MLFQ levels above the final FCFS level), promotion_threshold, mlq_q2_quantum,
+    switch_cost and resume_penalty (ticks of overhead, shown as Switch / Warmup segments).
+    Missing keys keep the C++ defaults. Returns None when config is empty.
+    """
+    if not config:
+        return None
+    c_config = SchedulerConfig()
+    c_config.aging_rate = int(config.get('aging_rate', 0))
+    c_config.promotion_threshold = int(config.get('promotion_threshold', 0))
+    c_config.mlq_q2_quantum = int(config.get('mlq_q2_quantum', 0))
+    c_config.switch_cost = int(config.get('switch_cost', 0))
+    c_config.resume_penalty = int(config.get('resume_penalty', 0))
+    quanta = config.get('mlfq_quanta')
+    if quanta is not None:
+        c_quanta = (ctypes.c_int * max(1, len(quanta)))(*[int(q) for q in quanta])
+        c_config._quanta = c_quanta # Keeps the array alive with the struct
+        c_config.mlfq_levels = len(quanta) + 1
+        c_config.mlfq_quanta = c_quanta
+    return c_config
+
+
+def _metrics(summary):
+    return {
+        "segments": summary.segments,
+        "makespan": summary.makespan,
+        "idle_time": summary.idle_time,
+        "context_switches": summary.context_switches,
+        "avg_tat": summary.avg_tat,
+        "avg_wt": summary.avg_wt,
+        "avg_rt": summary.avg_rt,
+        "switch_time": summary.switch_time,
+        "warmup_time": summary.warmup_time,
     }
-    algo_code = algo_map.get(algorithm_name, 0)
-    
-    processes = processes_input
-    
-    # --- MLQ Assignment Logic ---
-    if algo_code == 7 and mlq_assignments:
-        processes = []
-        for p in processes_input:
-            p_new = p.copy()
-            # Assign the target queue ID (1, 2, or 3) from the Streamlit input
-            # If the process isn't in mlq_assignments (shouldn't happen), default to Q3
-            p_new['queue_assignment'] = mlq_assignments.get(p['pid'], 3) 
-            processes.append(p_new)
 
-    # Convert Python dicts to C structs
-    for i, p in enumerate(processes):
+
+def _summary(stats):
+    return {name: getattr(stats, name) for name, _ in MetricSummary._fields_}
+
+
+def _metrics_dict(metrics):
+    out = {}
+    for name, field_type in SchedulerMetrics._fields_:
+        value = getattr(metrics, name)
+        out[name] = _summary(value) if field_type is MetricSummary else value
+    return out
+
+
+def _results_frame(results, algo_code):
+    rt = np.where(results['first_run'] != -1, results['first_run'] - results['at'], 0)
+    final_df = pd.DataFrame({
+        "pid": "P" + pd.Series(results['pid']).astype(str),
+        "at": results['at'],
+        "bt": results['bt'],
+        "ct": results['ct'],
+        "tat": results['tat'],
+        "wt": results['wt'],
+        "rt": rt,
+        "current_queue": results['current_queue'],
+        "status": "completed",
+    })
+    # For MLQ, show the assigned queue as the priority for clarity
+    final_df['priority'] = results['current_queue'] if algo_code == 7 else results['base_priority']
+    return final_df
+
+
+def _timeline(gantt, resources=None):
+    """Turns a GANTT_DTYPE (or SMP_GANTT_DTYPE) array into the timeline dicts the UI plots."""
+    pids = pd.Series(gantt['pid'])
+    tasks = ("P" + pids.astype(str)).where(pids > 0, pids.map(OVERHEAD_TASKS))
+    return pd.DataFrame({
+        "Task": tasks,
+        "Start": gantt['start'],
+        "Finish": gantt['finish'],
+        "Resource": tasks if resources is None else resources,
+    }).to_dict('records')
+
+
+# --- Result cache ---
+class ResultCache:
+    """
+    Thread-safe LRU of run_batch_arrays results, keyed by a hash of the process array, the
+    job (algorithm_code, quantum, mlq_queues, config) and the engine build. max_bytes
+    bounds the arrays held in memory. With a directory, entries are also written there as
+    .npz files (atomically, so several worker processes can share one directory) and
+    looked up on a memory miss. The directory is never pruned.
+    """
+
+    def __init__(self, max_bytes=256 << 20, directory=None):
+        self.max_bytes = int(max_bytes)
+        self.directory = directory
+        self.hits = 0
+        self.misses = 0
+        self._bytes = 0
+        self._entries = OrderedDict()
+        self._lock = threading.Lock()
+        if directory:
+            os.makedirs(directory, exist_ok=True)
+
+    def get(self, key):
+        with self._lock:
+            entry = self._entries.get(key)
+            if entry is not None:
+                self._entries.move_to_end(key)
+                self.hits += 1
+        if entry is None and self.directory:
+            entry = self._load(key)
+            if entry is not None:
+                self._remember(key, entry)
+                with self._lock:
+                    self.hits += 1
+        if entry is None:
+            with self._lock:
+                self.misses += 1
+            return None
+        results, gantt, metrics = entry
+        return results.copy(), gantt.copy(), dict(metrics)
+
+    def put(self, key, results, gantt, metrics):
+        # Copies, so callers may modify what they were given; this also drops the unused
+        # tail of the bound-sized Gantt buffer
+        entry = (results.copy(), gantt.copy(), dict(metrics))
+        self._remember(key, entry)
+        if self.directory:
+            self._store(key, entry)
+
+    def clear(self):
+        with self._lock:
+            self._entries.clear()
+            self._bytes = 0
+            self.hits = self.misses = 0
+
+    def info(self):
+        with self._lock:
+            return {"hits": self.hits, "misses": self.misses, "entries": len(self._entries),
+                    "bytes": self._bytes, "max_bytes": self.max_bytes, "directory": self.directory}
+
+    def _remember(self, key, entry):
+        size = entry[0].nbytes + entry[1].nbytes
+        if size > self.max_bytes:
+            return
+        with self._lock:
+            if key in self._entries:
+                return
+            self._entries[key] = entry
+            self._bytes += size
+            while self._bytes > self.max_bytes:
+                _, (results, gantt, _) = self._entries.popitem(last=False)
+                self._bytes -= results.nbytes + gantt.nbytes
+
+    def _path(self, key):
+        return os.path.join(self.directory, key + ".npz")
+
+    def _load(self, key):
         try:
-            pid_num = int(str(p['pid']).replace('P', ''))
-        except:
-            pid_num = i + 1
-            
-        c_procs[i].pid = pid_num
-        c_procs[i].at = int(p['at'])
-        c_procs[i].bt = int(p['bt'])
-        c_procs[i].rem_time = int(p['bt'])
-        
-        # Priority mapping: 
-        if algo_code == 7:
-            # For MLQ, we store the assigned Queue ID in the priority field for C++ initialization.
-            c_procs[i].priority = int(p['queue_assignment'])
-            c_procs[i].base_priority = int(p['priority']) # Store original priority separately
-        else:
-            # Standard priority scheduling
-            c_procs[i].priority = int(p['priority'])
-            c_procs[i].base_priority = int(p['priority'])
-            
-        
-        # Initialize extended fields
-        c_procs[i].current_priority = int(p['priority']) # Initial current priority
-        c_procs[i].first_run = -1 
-        c_procs[i].current_queue = -1
-        c_procs[i].last_q3_entry = -1
-
-    max_logs = 1000
-    LogArray = GanttLog * max_logs
-    c_logs = LogArray()
+            with np.load(self._path(key), allow_pickle=False) as data:
+                return data['results'], data['gantt'], json.loads(str(data['metrics']))
+        except (OSError, KeyError, ValueError):
+            return None # Not cached yet, or left unreadable by another process
+
+    def _store(self, key, entry):
+        results, gantt, metrics = entry
+        path = self._path(key)
+        tmp = f"{path}.{os.getpid()}.{threading.get_ident()}.tmp"
+        try:
+            with open(tmp, "wb") as f:
+                np.savez(f, results=results, gantt=gantt, metrics=np.array(json.dumps(metrics)))
+            os.replace(tmp, path)
+        except OSError:
+            # The disk copy is only an optimization
+            try:
+                os.remove(tmp)
+            except OSError:
+                pass
+
+
+def _engine_id():
+    """Identifies the loaded engine build, so a disk cache never serves results of another build."""
+    paths = [dll_path] + ([native.__file__] if native is not None else [])
+    parts = []
+    for path in paths:
+        try:
+            st_info = os.stat(path)
+            parts.append(f"{path}:{st_info.st_size}:{st_info.st_mtime_ns}")
+        except OSError:
+            parts.append(path)
+    return "|".join(parts).encode()
+
+
+# SCHEDULER_CACHE_BYTES sets the memory bound (0 disables caching), SCHEDULER_CACHE_DIR
+# turns on the shared disk cache
+result_cache = ResultCache(
+    int(os.environ.get("SCHEDULER_CACHE_BYTES", 256 << 20)), os.environ.get("SCHEDULER_CACHE_DIR") or None
+)
+_ENGINE_ID = _engine_id()
+
+
+def configure_result_cache(max_bytes=256 << 20, directory=None):
+    """Replaces the result cache used by run_batch_arrays; max_bytes=0 disables it."""
+    global result_cache
+    result_cache = ResultCache(max_bytes, directory)
+    return result_cache
+
+
+def _job_keys(procs, jobs):
+    """Content hashes of each job over procs (a contiguous PROCESS_DTYPE array)."""
+    base = hashlib.blake2b(_ENGINE_ID, digest_size=20)
+    base.update(procs.data)
+    keys = []
+    for spec in jobs:
+        h = base.copy()
+        code = int(spec['algorithm_code'])
+        # Only RR reads the quantum, so the quantum slider does not miss for the other policies
+        quantum = int(spec.get('quantum', 2)) if code == 5 else 0
+        h.update(struct.pack("<ii", code, quantum))
+        queues = spec.get('mlq_queues')
+        if queues is not None:
+            h.update(b"q")
+            h.update(np.ascontiguousarray(queues, dtype=np.int32).data)
+        config = spec.get('config')
+        if config:
+            h.update(json.dumps(config, sort_keys=True, default=str).encode())
+        keys.append(h.hexdigest())
+    return keys
+
+
+def run_batch_arrays(procs, jobs, workers=0, cache=True):
+    """
+    Runs several jobs over a PROCESS_DTYPE array in one C++ call, without per-row
+    marshalling: the array and every output buffer are handed over as raw pointers.
+    Each job is a dict with algorithm_code, quantum and optionally mlq_queues (array with
+    one queue id per process) and config (see _to_c_config). Returns one
+    (results, gantt, metrics) tuple per job, where results is a PROCESS_DTYPE array and
+    gantt a GANTT_DTYPE view of the merged timeline.
+    Jobs already in result_cache are not run again unless cache is False.
+    """
+    procs = np.ascontiguousarray(procs, dtype=PROCESS_DTYPE)
+    if not cache or result_cache.max_bytes <= 0 or len(jobs) == 0:
+        return _run_batch_uncached(procs, jobs, workers)
+
+    cache_used = result_cache # Stays the same even if reconfigured meanwhile
+    keys = _job_keys(procs, jobs)
+    outputs = [cache_used.get(key) for key in keys]
+    missing = [j for j, output in enumerate(outputs) if output is None]
+    if missing:
+        for j, output in zip(missing, _run_batch_uncached(procs, [jobs[j] for j in missing], workers)):
+            cache_used.put(keys[j], *output)
+            outputs[j] = output
+    return outputs
+
+
+def _run_batch_uncached(procs, jobs, workers):
+    n = len(procs)
+    if native is not None:
+        return _run_batch_native(procs, jobs, workers)
+
+    c_procs = procs.ctypes.data_as(ctypes.POINTER(Process))
+    c_jobs = (BatchJob * len(jobs))()
+    buffers = [] # Keeps the per-job arrays alive until the call returns
+
+    for j, spec in enumerate(jobs):
+        job = c_jobs[j]
+        job.algorithm_code = int(spec['algorithm_code'])
+        job.quantum = int(spec.get('quantum', 2))
+
+        c_config = _to_c_config(spec.get('config'))
+        if c_config is not None:
+            job.config = ctypes.pointer(c_config)
+
+        queues = spec.get('mlq_queues')
+        if queues is not None:
+            queues = np.ascontiguousarray(queues, dtype=np.int32)
+            job.mlq_queues = queues.ctypes.data_as(ctypes.POINTER(ctypes.c_int))
+
+        # Size the Gantt buffer from the engine's upper bound so the run is never truncated
+        max_logs = max(1, lib.scheduler_job_log_bound(c_procs, n, ctypes.byref(job)))
+        gantt = np.zeros(max_logs, dtype=GANTT_DTYPE)
+        results = np.zeros(n, dtype=PROCESS_DTYPE)
+        job.logs = gantt.ctypes.data_as(ctypes.POINTER(GanttLog))
+        job.max_logs = max_logs
+        job.results = results.ctypes.data_as(ctypes.POINTER(Process))
+        buffers.append((results, gantt, queues, c_config))
+
+    c_summary = (BatchResult * len(jobs))()
 
     # --- CALL C++ ---
-    count = lib.run_scheduler(c_procs, n, algo_code, int(quantum), c_logs, max_logs)
+    lib.run_scheduler_batch_mt(c_procs, n, c_jobs, len(jobs), c_summary, 0, int(workers))
 
-    # --- Convert Results back to Python format ---
-    
-    final_data = []
-    for i in range(n):
-        p = c_procs[i]
-        rt = p.first_run - p.at if p.first_run != -1 else 0
-        
-        final_pid_data = {
-            "pid": f"P{p.pid}",
-            "at": p.at,
-            "bt": p.bt,
-            "ct": p.ct,
-            "tat": p.tat,
-            "wt": p.wt,
-            "rt": rt,
-            "current_queue": p.current_queue,
-            "status": "completed"
+    outputs = []
+    for (results, gantt, _, _), summary in zip(buffers, c_summary):
+        outputs.append((results, gantt[:min(summary.segments, len(gantt))], _metrics(summary)))
+    return outputs
+
+
+def _run_batch_native(procs, jobs, workers):
+    """run_batch_arrays through the _scheduler extension; same inputs and outputs."""
+    n = len(procs)
+    native_jobs = []
+    for spec in jobs:
+        job = {
+            "algorithm_code": int(spec['algorithm_code']),
+            "quantum": int(spec.get('quantum', 2)),
+            "config": spec.get('config') or None,
         }
-        
-        if algo_code == 7:
-             # For MLQ, show the assigned queue as the priority for clarity
-             final_pid_data['priority'] = p.current_queue 
-        else:
-             final_pid_data['priority'] = p.base_priority
-             
-        final_data.append(final_pid_data)
-        
-    final_df = pd.DataFrame(final_data)
-
-    # 2. Timeline
-    timeline = []
-    for i in range(count):
-        l = c_logs[i]
-        task_name = "Idle" if l.pid == -1 else f"P{l.pid}"
-        timeline.append({
-            "Task": task_name,
-            "Start": l.start,
-            "Finish": l.finish,
-            "Resource": task_name
-        })
-
-    return final_df, timeline
\ No newline at end of file
+        queues = spec.get('mlq_queues')
+        if queues is not None:
+            job["mlq_queues"] = np.ascontiguousarray(queues, dtype=np.int32)
+
+        max_logs = max(1, native.job_log_bound(procs, job))
+        job["logs"] = np.zeros(max_logs, dtype=GANTT_DTYPE)
+        job["results"] = np.zeros(n, dtype=PROCESS_DTYPE)
+        native_jobs.append(job)
+
+    # --- CALL C++ (GIL released) ---
+    summaries = native.run_batch(procs, native_jobs, int(workers))
+
+    outputs = []
+    for job, metrics in zip(native_jobs, summaries):
+        gantt = job["logs"]
+        outputs.append((job["results"], gantt[:min(metrics["segments"], len(gantt))], metrics))
+    return outputs
+
+
+def run_metrics_arrays(procs, jobs, workers=0):
+    """
+    Like run_batch_arrays, but only returns each job's metrics: the engine skips Gantt
+    logging and per-process output, and its memory does not grow with the timeline. Each
+    result is a dict of the run totals plus mean/p50/p95/p99/max dicts for wt, tat and rt.
+    """
+    procs = np.ascontiguousarray(procs, dtype=PROCESS_DTYPE)
+    c_jobs = (BatchJob * len(jobs))()
+    buffers = [] # Keeps the queue arrays and configs alive until the call returns
+
+    for j, spec in enumerate(jobs):
+        job = c_jobs[j]
+        job.algorithm_code = int(spec['algorithm_code'])
+        job.quantum = int(spec.get('quantum', 2))
+        c_config = _to_c_config(spec.get('config'))
+        if c_config is not None:
+            job.config = ctypes.pointer(c_config)
+        queues = spec.get('mlq_queues')
+        if queues is not None:
+            queues = np.ascontiguousarray(queues, dtype=np.int32)
+            job.mlq_queues = queues.ctypes.data_as(ctypes.POINTER(ctypes.c_int))
+        buffers.append((queues, c_config))
+
+    c_metrics = (SchedulerMetrics * len(jobs))()
+
+    # --- CALL C++ ---
+    lib.run_scheduler_metrics_batch(procs.ctypes.data_as(ctypes.POINTER(Process)), len(procs),
+                                    c_jobs, len(jobs), c_metrics, 0, int(workers))
+    return [_metrics_dict(m) for m in c_metrics]
+
+
+def _jobs_from_runs(df, runs):
+    """Turns solve_scheduling_batch style run tuples into run_batch_arrays job dicts."""
+    jobs = []
+    for run in runs:
+        algorithm_name, quantum, mlq_assignments = run[:3]
+        job = {
+            "algorithm_code": ALGO_MAP.get(algorithm_name, 0),
+            "quantum": quantum,
+            "config": run[3] if len(run) > 3 else None,
+        }
+        # --- MLQ Assignment Logic ---
+        if job["algorithm_code"] == 7 and mlq_assignments:
+            # If the process isn't in mlq_assignments (shouldn't happen), default to Q3
+            job["mlq_queues"] = df['pid'].map(mlq_assignments).fillna(3).astype(np.int64).to_numpy()
+        jobs.append(job)
+    return jobs
+
+
+def solve_scheduling_metrics(processes_input, runs, workers=0):
+    """
+    Summary statistics for each run (same run tuples as solve_scheduling_batch), for
+    sweeps that do not need the result table or the timeline.
+    """
+    if len(processes_input) == 0:
+        return [{} for _ in runs]
+    procs, df = _process_array(processes_input)
+    return run_metrics_arrays(procs, _jobs_from_runs(df, runs), workers)
+
+
+def solve_scheduling_batch(processes_input, runs, workers=0):
+    """
+    Simulates several configurations over one workload with a single C++ call.
+    runs is a list of (algorithm_name, quantum, mlq_assignments) tuples, optionally with a
+    fourth config dict (see _to_c_config); returns one (final_df, timeline, metrics) tuple
+    per run, in the same order.
+    workers sets the C++ thread count for the sweep (0 = all cores).
+    """
+    if len(processes_input) == 0:
+        return [(pd.DataFrame(), [], {}) for _ in runs]
+
+    procs, df = _process_array(processes_input)
+    jobs = _jobs_from_runs(df, runs)
+
+    # --- Convert Results back to Python format ---
+    outputs = []
+    for job, (results, gantt, metrics) in zip(jobs, run_batch_arrays(procs, jobs, workers)):
+        outputs.append((_results_frame(results, job["algorithm_code"]), _timeline(gantt), metrics))
+    return outputs
+
+
+def solve_scheduling(processes_input, algorithm_name, quantum=2, mlq_assignments=None, config=None):
+    final_df, timeline, _ = solve_scheduling_batch(
+        processes_input, [(algorithm_name, quantum, mlq_assignments, config)]
+    )[0]
+    return final_df, timeline
+
+
+def solve_scheduling_io(processes_input, algorithm_name, quantum=2, mlq_assignments=None, config=None):
+    """
+    solve_scheduling for processes that alternate CPU and I/O. A process dict may carry
+    "bursts", a list [cpu, io, cpu, ..., cpu] with every CPU burst > 0 (otherwise bt is
+    its only CPU burst), and "devices", the device index of each I/O burst (default 0).
+    Each device serves one I/O at a time, in request order. The result table's bt is the
+    total CPU time, wt excludes the time blocked on I/O, and io_time gives the latter.
+    """
+    if len(processes_input) == 0:
+        return pd.DataFrame(), []
+
+    algo_code = ALGO_MAP.get(algorithm_name, 0)
+    procs, df = _process_array(processes_input)
+    if algo_code == 7 and mlq_assignments:
+        # Without a queue column the engine reads the MLQ queue from priority
+        procs['priority'] = df['pid'].map(mlq_assignments).fillna(3).astype(np.int64).to_numpy()
+
+    offsets, bursts, devices = [0], [], []
+    for p in processes_input:
+        plan = [int(b) for b in p.get('bursts') or []]
+        io_devices = list(p.get('devices') or [])
+        for k, burst in enumerate(plan):
+            bursts.append(burst)
+            devices.append(int(io_devices[k // 2]) if k % 2 == 1 and k // 2 < len(io_devices) else 0)
+        offsets.append(len(bursts))
+    offsets = np.ascontiguousarray(offsets, dtype=np.int32)
+    bursts = np.ascontiguousarray(bursts or [0], dtype=np.int32)
+    devices = np.ascontiguousarray(devices or [0], dtype=np.int32)
+    c_plan = IoPlan()
+    c_plan.offsets = offsets.ctypes.data_as(ctypes.POINTER(ctypes.c_int))
+    c_plan.bursts = bursts.ctypes.data_as(ctypes.POINTER(ctypes.c_int))
+    c_plan.devices = devices.ctypes.data_as(ctypes.POINTER(ctypes.c_int))
+    c_plan.num_devices = int(devices.max()) + 1
+
+    c_config = _to_c_config(config)
+    c_config_ptr = ctypes.byref(c_config) if c_config is not None else None
+    c_procs = procs.ctypes.data_as(ctypes.POINTER(Process))
+    max_logs = lib.scheduler_io_log_bound(c_procs, len(procs), algo_code, int(quantum), c_config_ptr, ctypes.byref(c_plan))
+    if max_logs < 0:
+        raise ValueError("Invalid burst list: expected [cpu, io, ..., cpu] with CPU bursts > 0 and I/O bursts >= 0.")
+    gantt = np.zeros(max(1, max_logs), dtype=GANTT_DTYPE)
+
+    # --- CALL C++ ---
+    count = lib.run_scheduler_io(c_procs, len(procs), algo_code, int(quantum), c_config_ptr, ctypes.byref(c_plan),
+                                 gantt.ctypes.data_as(ctypes.POINTER(GanttLog)), len(gantt), 0)
+
+    final_df = _results_frame(procs, algo_code)
+    final_df['io_time'] = final_df['tat'] - final_df['wt'] - final_df['bt']
+    return final_df, _timeline(gantt[:count])
+
+
+def solve_scheduling_smp(processes_input, algorithm_name, num_cpus, quantum=2, balance="push", affinity=None,
+                         overhead=None):
+    """
+    Simulates the workload on num_cpus CPUs with per-CPU run queues. balance is one of
+    SMP_BALANCE_MAP; affinity optionally maps a pid to the CPU index it is pinned to.
+    overhead is an optional dict of switch_cost, resume_penalty and migration_penalty ticks.
+    MLFQ and MLQ are not available in SMP mode. The timeline's Resource is the CPU.
+    """
+    n = len(processes_input)
+
+    if n == 0:
+        return pd.DataFrame(), []
+
+    algo_code = ALGO_MAP.get(algorithm_name, 0)
+    if algo_code in (6, 7):
+        raise ValueError(f"{algorithm_name} is not supported in SMP mode.")
+
+    procs, df = _process_array(processes_input)
+    c_smp = SmpConfig()
+    c_smp.num_cpus = int(num_cpus)
+    c_smp.balance = SMP_BALANCE_MAP.get(balance, 1)
+    if overhead:
+        c_smp.switch_cost = int(overhead.get('switch_cost', 0))
+        c_smp.resume_penalty = int(overhead.get('resume_penalty', 0))
+        c_smp.migration_penalty = int(overhead.get('migration_penalty', 0))
+    if affinity:
+        pinned = np.ascontiguousarray(df['pid'].map(affinity).fillna(-1).astype(np.int64).to_numpy(), dtype=np.int32)
+        c_smp.affinity = pinned.ctypes.data_as(ctypes.POINTER(ctypes.c_int))
+
+    c_procs = procs.ctypes.data_as(ctypes.POINTER(Process))
+    max_logs = max(1, lib.scheduler_smp_config_log_bound(c_procs, n, algo_code, int(quantum), ctypes.byref(c_smp)))
+    gantt = np.zeros(max_logs, dtype=SMP_GANTT_DTYPE)
+
+    # --- CALL C++ ---
+    count = lib.run_scheduler_smp(c_procs, n, algo_code, int(quantum), ctypes.byref(c_smp),
+                                  gantt.ctypes.data_as(ctypes.POINTER(SmpGanttLog)), max_logs, 0)
+    if count < 0:
+        raise ValueError("Invalid SMP configuration.")
+
+    gantt = gantt[:count]
+    return _results_frame(procs, algo_code), _timeline(gantt, "CPU" + pd.Series(gantt['cpu']).astype(str))
+
+
+def _profile_dict(profile):
+    out = {"enabled": bool(profile.enabled), "clock": "tsc" if profile.clock == 1 else "ns",
+           "total_ns": profile.total_ticks * profile.tick_ns, "phases": {}}
+    for k, name in enumerate(PROFILE_PHASES):
+        out["phases"][name] = {"calls": profile.calls[k], "ticks": profile.ticks[k], "ns": profile.ticks[k] * profile.tick_ns}
+    for name in ("arrivals", "dispatches", "preemptions", "completions", "idle_gaps", "aging_steps", "segments",
+                 "max_ready", "trace_events", "trace_dropped"):
+        out[name] = getattr(profile, name)
+    return out
+
+
+def profile_scheduling(processes_input, algorithm_name, quantum=2, mlq_assignments=None, config=None, trace_path=None):
+    """
+    solve_scheduling with the engine's instrumentation: returns (final_df, timeline, profile),
+    where profile holds the calls, ticks and ns of each PROFILE_PHASES phase, the event
+    counts and max_ready, the most processes waiting at once. With trace_path a Chrome
+    trace JSON of the run is written there. Needs a library built with SCHEDULER_INSTRUMENT;
+    otherwise profile["enabled"] is False and the counters are zero.
+    """
+    if len(processes_input) == 0:
+        return pd.DataFrame(), [], {}
+
+    algo_code = ALGO_MAP.get(algorithm_name, 0)
+    procs, df = _process_array(processes_input)
+    if algo_code == 7 and mlq_assignments:
+        # Without a queue column the engine reads the MLQ queue from priority
+        procs['priority'] = df['pid'].map(mlq_assignments).fillna(3).astype(np.int64).to_numpy()
+    c_config = _to_c_config(config)
+    c_config_ptr = ctypes.byref(c_config) if c_config is not None else None
+    c_procs = procs.ctypes.data_as(ctypes.POINTER(Process))
+    max_logs = max(1, lib.scheduler_config_log_bound(c_procs, len(procs), algo_code, int(quantum), c_config_ptr))
+    gantt = np.zeros(max_logs, dtype=GANTT_DTYPE)
+    profile = SchedulerProfile()
+
+    # --- CALL C++ ---
+    count = lib.run_scheduler_profiled(c_procs, len(procs), algo_code, int(quantum), c_config_ptr,
+                                       gantt.ctypes.data_as(ctypes.POINTER(GanttLog)), max_logs, 0,
+                                       ctypes.byref(profile), os.fsencode(trace_path) if trace_path else None)
+    if count == -2:
+        raise OSError(f"Could not write the trace file {trace_path}.")
+    return _results_frame(procs, algo_code), _timeline(gantt[:count]), _profile_dict(profile)
+
+
+# --- Monte Carlo sweeps ---
+# Models for WorkloadSpec (ARRIVAL_* / BURST_* in scheduler.cpp)
+ARRIVAL_MODELS = {"poisson": 0, "bursty": 1, "uniform": 2}
+BURST_MODELS = {"uniform": 0, "exponential": 1, "pareto": 2, "lognormal": 3}
+
+
+def _to_c_workload(spec):
+    """
+    Builds a WorkloadSpec from a dict with num_processes and any of: arrival ("poisson",
+    "bursty" or "uniform"), arrival_rate, burstiness, burst ("uniform", "exponential",
+    "pareto" or "lognormal"), burst_mean, burst_shape, max_burst, max_priority and seed.
+    """
+    c_spec = WorkloadSpec()
+    c_spec.num_processes = int(spec['num_processes'])
+    c_spec.arrival_model = ARRIVAL_MODELS[spec.get('arrival', 'poisson')]
+    c_spec.arrival_rate = float(spec.get('arrival_rate', 0))
+    c_spec.burstiness = float(spec.get('burstiness', 0))
+    c_spec.burst_model = BURST_MODELS[spec.get('burst', 'uniform')]
+    c_spec.burst_mean = float(spec.get('burst_mean', 0))
+    c_spec.burst_shape = float(spec.get('burst_shape', 0))
+    c_spec.max_burst = int(spec.get('max_burst', 0))
+    c_spec.max_priority = int(spec.get('max_priority', 0))
+    c_spec.seed = int(spec.get('seed', 0))
+    return c_spec
+
+
+def generate_workload(spec, index=0):
+    """Workload number index of spec (see _to_c_workload) as a PROCESS_DTYPE array, exactly as monte_carlo draws it."""
+    c_spec = _to_c_workload(spec)
+    procs = np.zeros(c_spec.num_processes, dtype=PROCESS_DTYPE)
+    if lib.generate_workload(ctypes.byref(c_spec), int(index), procs.ctypes.data_as(ctypes.POINTER(Process))) < 0:
+        raise ValueError("Invalid workload spec.")
+    return procs
+
+
+def monte_carlo(spec, runs, workloads=1000, confidence=0.95, workers=0):
+    """
+    Generates workloads random workloads from spec (see _to_c_workload) in C++, in
+    parallel, and runs each (algorithm_name, quantum[, config]) run on all of them.
+    Returns one dict per run mapping each metric (avg_wt, avg_tat, avg_rt, p99_wt,
+    p99_tat, makespan, utilization, throughput, context_switches) to its mean, stddev and
+    the low/high ends of the confidence interval of the mean. MLQ takes each process's
+    queue from its generated priority (clamped to 1-3). Results only depend on the seed.
+    """
+    c_spec = _to_c_workload(spec)
+    c_jobs = (BatchJob * max(1, len(runs)))()
+    configs = [] # Keeps the configs alive until the call returns
+    for j, run in enumerate(runs):
+        c_jobs[j].algorithm_code = ALGO_MAP.get(run[0], 0)
+        c_jobs[j].quantum = int(run[1]) if len(run) > 1 else 2
+        c_config = _to_c_config(run[2] if len(run) > 2 else None)
+        if c_config is not None:
+            c_jobs[j].config = ctypes.pointer(c_config)
+        configs.append(c_config)
+    c_summaries = (MonteCarloSummary * max(1, len(runs)))()
+
+    # --- CALL C++ ---
+    if lib.run_monte_carlo(ctypes.byref(c_spec), int(workloads), c_jobs, len(runs), float(confidence),
+                           c_summaries, int(workers)) < 0:
+        raise ValueError("Invalid Monte Carlo arguments.")
+    return [
+        {name: {field: getattr(getattr(summary, name), field) for field, _ in MetricInterval._fields_}
+         for name, _ in MonteCarloSummary._fields_[1:]}
+        for summary in c_summaries[:len(runs)]
+    ]
+
+
+# --- Binary traces ---
+# Header shared by trace, Gantt and results files (see TraceFileHeader in scheduler.cpp):
+# magic, version, flags, count, four column offsets, reserved.
+TRACE_HEADER = struct.Struct("<8sIIQ4QQ")
+TRACE_FLAG_DELTA_AT = 1
+
+
+def write_trace(path, at, bt, priority, queue=None, delta_at=False):
+    """
+    Writes a binary trace with int32 at/bt/priority columns and an optional MLQ queue
+    column, without going through per-row Python. With delta_at, arrivals are stored as
+    gaps to the previous one, which requires at to be in arrival order. Entry k gets pid k + 1.
+    """
+    columns = [np.asarray(at, dtype=np.int64), np.asarray(bt), np.asarray(priority)]
+    if queue is not None:
+        columns.append(np.asarray(queue))
+    n = len(columns[0])
+    if any(len(c) != n for c in columns):
+        raise ValueError("Trace columns must all have the same length.")
+
+    flags = 0
+    if delta_at:
+        deltas = np.diff(columns[0], prepend=0)
+        if n and deltas.min() < 0:
+            raise ValueError("delta_at needs arrivals sorted by arrival time.")
+        columns[0] = deltas
+        flags |= TRACE_FLAG_DELTA_AT
+
+    offsets = [TRACE_HEADER.size + k * 4 * n for k in range(len(columns))] + [0] * (4 - len(columns))
+    with open(path, "wb") as f:
+        f.write(TRACE_HEADER.pack(b"HOSTRACE", 1, flags, n, *offsets, 0))
+        for column in columns:
+            f.write(column.astype("<i4").tobytes())
+
+
+def _read_header(path, magic):
+    with open(path, "rb") as f:
+        fields = TRACE_HEADER.unpack(f.read(TRACE_HEADER.size))
+    if fields[0] != magic:
+        raise ValueError(f"{path} is not a {magic.decode()} file.")
+    return fields[3], fields[4:8]
+
+
+def read_gantt(path):
+    """Memory-maps a Gantt file written by run_trace as a read-only GANTT_DTYPE array."""
+    count, offsets = _read_header(path, b"HOSGANTT")
+    if count == 0:
+        return np.zeros(0, dtype=GANTT_DTYPE)
+    return np.memmap(path, dtype=GANTT_DTYPE, mode="r", offset=offsets[0], shape=(count,))
+
+
+def read_trace_results(path):
+    """Memory-maps a results file written by run_trace as {"ct", "first_run", "current_queue"} arrays."""
+    count, offsets = _read_header(path, b"HOSRESLT")
+    names = ("ct", "first_run", "current_queue")
+    if count == 0:
+        return {name: np.zeros(0, dtype=np.int32) for name in names}
+    return {name: np.memmap(path, dtype="<i4", mode="r", offset=offsets[k], shape=(count,)) for k, name in enumerate(names)}
+
+
+def run_trace(trace_path, algorithm_name, gantt_path, results_path=None, quantum=2, config=None):
+    """
+    Simulates a binary trace entirely in C++: the trace is memory-mapped and simulated in
+    place, and the timeline (and optionally the per-process results) are written to
+    memory-mapped files readable with read_gantt / read_trace_results.
+    Returns the number of Gantt segments written.
+    """
+    c_config = _to_c_config(config)
+    count = lib.run_scheduler_trace(
+        os.fsencode(trace_path), ALGO_MAP.get(algorithm_name, 0), int(quantum),
+        ctypes.byref(c_config) if c_config is not None else None,
+        os.fsencode(gantt_path), os.fsencode(results_path) if results_path else None, 0
+    )
+    if count == -1:
+        raise ValueError(f"{trace_path} is not a readable trace file.")
+    if count < 0:
+        raise OSError("Could not write the trace output files.")
+    return count
+
+
+# --- Online sessions ---
+class SchedulerSession:
+    """
+    Schedules a live job feed incrementally: submit processes as they become known, call
+    advance_to(t) once no process arriving before t can still be submitted, and drain the
+    segments and completions decided so far. Only new events are simulated on each call,
+    and the output matches solve_scheduling over the same processes.
+    """
+
+    def __init__(self, algorithm_name, quantum=2, config=None):
+        self.algo_code = ALGO_MAP.get(algorithm_name, 0)
+        c_config = _to_c_config(config)
+        self._handle = lib.scheduler_session_create(
+            self.algo_code, int(quantum), ctypes.byref(c_config) if c_config is not None else None
+        )
+        if not self._handle:
+            raise MemoryError("Could not create a scheduler session.")
+
+    def submit(self, at, bt, priority=1):
+        """Adds a process (for MLQ, priority is its queue) and returns its pid."""
+        pid = lib.scheduler_session_submit(self._handle, int(at), int(bt), int(priority))
+        if pid < 0:
+            raise ValueError(f"Cannot submit an arrival at {at}: the session has advanced past it or is closed.")
+        return pid
+
+    def advance_to(self, t):
+        """Schedules everything that is final up to t. Returns the number of segments ready."""
+        return lib.scheduler_session_advance(self._handle, int(t))
+
+    def close(self):
+        """Ends the feed and runs the submitted processes to completion."""
+        return lib.scheduler_session_close(self._handle)
+
+    def drain_segments(self):
+        """Returns the closed Gantt segments not drained yet, in timeline dict form."""
+        count = lib.scheduler_session_drain_segments(self._handle, None, 0)
+        gantt = np.zeros(max(0, count), dtype=GANTT_DTYPE)
+        if count > 0:
+            lib.scheduler_session_drain_segments(self._handle, gantt.ctypes.data_as(ctypes.POINTER(GanttLog)), count)
+        return _timeline(gantt)
+
+    def drain_completions(self):
+        """Returns the processes that finished since the last call as a PROCESS_DTYPE array."""
+        count = lib.scheduler_session_drain_completions(self._handle, None, 0)
+        results = np.zeros(max(0, count), dtype=PROCESS_DTYPE)
+        if count > 0:
+            lib.scheduler_session_drain_completions(self._handle, results.ctypes.data_as(ctypes.POINTER(Process)), count)
+        return results
+
+    def destroy(self):
+        if getattr(self, "_handle", None):
+            lib.scheduler_session_destroy(self._handle)
+            self._handle = None
+
+    def __del__(self):
+        if dll_loaded:
+            self.destroy()
+
+
+# --- Gantt levels of detail ---
+def _gantt_array(timeline):
+    """Turns timeline dicts (as returned by solve_scheduling) back into a GANTT_DTYPE array."""
+    gantt = np.zeros(len(timeline), dtype=GANTT_DTYPE)
+    if len(timeline) == 0:
+        return gantt
+    df = pd.DataFrame(timeline)
+    overhead_pids = {name: pid for pid, name in OVERHEAD_TASKS.items()}
+    tasks = df['Task'].astype(str)
+    pids = pd.to_numeric(tasks.str.replace('P', '', regex=False), errors='coerce')
+    gantt['pid'] = pids.fillna(tasks.map(overhead_pids)).fillna(-1).astype(np.int64).to_numpy()
+    gantt['start'] = df['Start'].astype(np.int64).to_numpy()
+    gantt['finish'] = df['Finish'].astype(np.int64).to_numpy()
+    return gantt
+
+
+class GanttLod:
+    """
+    Multi-resolution index of a single-CPU timeline (a GANTT_DTYPE array or timeline
+    dicts), built once in C++. query(t0, t1, pixels) returns at most pixels + 2 entries
+    for any range, so charts and replays of long runs never walk the whole timeline.
+    """
+
+    def __init__(self, gantt):
+        if not isinstance(gantt, np.ndarray):
+            gantt = _gantt_array(gantt)
+        gantt = np.ascontiguousarray(gantt, dtype=GANTT_DTYPE)
+        self.segments = len(gantt)
+        self.end = int(gantt['finish'][-1]) if len(gantt) else 0
+        self._handle = lib.gantt_lod_create(gantt.ctypes.data_as(ctypes.POINTER(GanttLog)), len(gantt))
+        if not self._handle:
+            raise ValueError("The timeline overlaps or is out of order (only single-CPU timelines are supported).")
+
+    def query_array(self, t0, t1, pixels):
+        """The view of [t0, t1) at pixels columns as a GANTT_LOD_DTYPE array (see gantt_lod_query)."""
+        out = np.zeros(max(1, int(pixels)) + 2, dtype=GANTT_LOD_DTYPE)
+        count = lib.gantt_lod_query(self._handle, int(t0), int(t1), int(pixels),
+                                    out.ctypes.data_as(ctypes.POINTER(GanttLodSegment)), len(out))
+        return out[:max(0, count)]
+
+    def query(self, t0, t1, pixels):
+        """
+        Timeline dicts covering [t0, t1): the segments themselves when at most pixels of
+        them fall in the range, otherwise one entry per run of buckets whose longest-running
+        task is the same. Utilization is the share of each entry spent running processes.
+        """
+        view = self.query_array(t0, t1, pixels)
+        timeline = _timeline(view)
+        for entry, busy, start, finish in zip(timeline, view['busy'], view['start'], view['finish']):
+            entry["Utilization"] = float(busy) / max(1, int(finish) - int(start))
+        return timeline
+
+    def task_at(self, t):
+        """Task running at time t ("Idle" outside the timeline)."""
+        view = self.query_array(t, t + 1, 1)
+        return _timeline(view)[0]["Task"] if len(view) else "Idle"
+
+    def destroy(self):
+        if getattr(self, "_handle", None):
+            lib.gantt_lod_destroy(self._handle)
+            self._handle = None
+
+    def __del__(self):
+        if dll_loaded:
+            self.destroy()
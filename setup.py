@@ -0,0 +1,28 @@
+"""
+Builds the native _scheduler extension module used by scheduler_wrapper.py when present:
+
+    python setup.py build_ext --inplace
+"""
+import sys
+from setuptools import setup, Extension
+
+if sys.platform == "win32":
+    compile_args = ["/O2", "/std:c++17"]
+    link_args = []
+else:
+    compile_args = ["-O3", "-std=c++17", "-pthread"]
+    link_args = ["-pthread"]
+
+setup(
+    name="hybrid-os-scheduler",
+    ext_modules=[
+        Extension(
+            "_scheduler",
+            sources=["scheduler_module.cpp"],
+            depends=["scheduler.cpp"],
+            extra_compile_args=compile_args,
+            extra_link_args=link_args,
+            language="c++",
+        )
+    ],
+)